@@ -0,0 +1,577 @@
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+#include <functional>
+#include <iostream>
+#include <new>
+#include <span>
+#include <string_view>
+#include <thread>
+#include <tuple>
+#include <vector>
+
+#include "box_rigid_body_desc.h"
+#include "collision_event.h"
+#include "physics_config.h"
+#include "physics_manager.h"
+#include "rigid_body.h"
+#include "trigger_event.h"
+#include "vector3.h"
+
+#include "LinearMath/btAlignedAllocator.h"
+
+namespace
+{
+
+/** Number of heap allocations made so far, by both the engine and bullet. */
+std::atomic<std::uint64_t> allocation_count{0u};
+
+/**
+ * Allocation function installed into bullet so its allocations are counted.
+ *
+ * @param size
+ *   Number of bytes to allocate.
+ *
+ * @returns
+ *   Allocated memory.
+ */
+void *counting_bullet_alloc(std::size_t size)
+{
+    allocation_count.fetch_add(1u, std::memory_order_relaxed);
+    return std::malloc(size);
+}
+
+/**
+ * Free function installed into bullet to match counting_bullet_alloc.
+ *
+ * @param memory
+ *   Memory to free.
+ */
+void counting_bullet_free(void *memory)
+{
+    std::free(memory);
+}
+
+/** Length of a physics tick, the benchmark runs exactly one tick per update. */
+constexpr auto tick_length = 1.0f / 60.0f;
+
+/** Number of ticks to run before timing, so the stacks have settled into contact. */
+constexpr auto warmup_ticks = 30u;
+
+/** Number of ticks to time. */
+constexpr auto timed_ticks = 120u;
+
+/**
+ * Add a ground and a grid of box stacks to the simulation.
+ *
+ * @param pm
+ *   The PhysicsManager to add boxes to.
+ *
+ * @param box_count
+ *   Total number of boxes to add.
+ *
+ * @param ground_plane
+ *   True to use a static plane as the ground, otherwise a static box.
+ *
+ * @returns
+ *   Handles to the boxes, not including the ground.
+ */
+std::vector<bab::RigidBody> add_stacked_boxes(bab::PhysicsManager &pm, std::uint32_t box_count, bool ground_plane)
+{
+    constexpr auto stack_height = 10u;
+    constexpr auto half_extent = 1.0f;
+    constexpr auto spacing = 3.0f;
+
+    const auto stack_count = (box_count + stack_height - 1u) / stack_height;
+    const auto grid_size = static_cast<std::uint32_t>(std::ceil(std::sqrt(static_cast<float>(stack_count))));
+    const auto grid_offset = static_cast<float>(grid_size) * spacing * 0.5f;
+
+    if (ground_plane)
+    {
+        pm.add_static_plane_rigid_body({0.0f, 1.0f, 0.0f}, 0.0f);
+    }
+    else
+    {
+        pm.add_static_rigid_body({grid_offset + spacing, 1.0f, grid_offset + spacing}, {0.0f, -1.0f, 0.0f});
+    }
+
+    std::vector<bab::RigidBody> boxes{};
+    boxes.reserve(box_count);
+
+    for (auto i = 0u; i < box_count; ++i)
+    {
+        const auto stack = i / stack_height;
+        const auto level = i % stack_height;
+
+        const bab::Vector3 position{
+            static_cast<float>(stack % grid_size) * spacing - grid_offset,
+            half_extent + static_cast<float>(level) * half_extent * 2.0f,
+            static_cast<float>(stack / grid_size) * spacing - grid_offset};
+
+        boxes.push_back(pm.add_dynamic_rigid_body({half_extent, half_extent, half_extent}, position, 1.0f));
+    }
+
+    return boxes;
+}
+
+/**
+ * Add a static box ground and a grid of box stacks to the simulation.
+ *
+ * @param pm
+ *   The PhysicsManager to add boxes to.
+ *
+ * @param box_count
+ *   Total number of boxes to add.
+ */
+void add_box_stacks(bab::PhysicsManager &pm, std::uint32_t box_count)
+{
+    add_stacked_boxes(pm, box_count, false);
+}
+
+/**
+ * Add a ground plane and a grid of box stacks to the simulation.
+ *
+ * @param pm
+ *   The PhysicsManager to add boxes to.
+ *
+ * @param box_count
+ *   Total number of boxes to add.
+ */
+void add_plane_stacks(bab::PhysicsManager &pm, std::uint32_t box_count)
+{
+    add_stacked_boxes(pm, box_count, true);
+}
+
+/**
+ * Add a level made of a grid of static boxes, with a scattering of dynamic boxes dropped onto it.
+ *
+ * @param pm
+ *   The PhysicsManager to add boxes to.
+ *
+ * @param box_count
+ *   Total number of boxes to add, one in ten is dynamic.
+ */
+void add_static_level(bab::PhysicsManager &pm, std::uint32_t box_count)
+{
+    constexpr auto half_extent = 1.0f;
+    constexpr auto spacing = 2.5f;
+    constexpr auto dynamic_every = 10u;
+
+    const auto grid_size = static_cast<std::uint32_t>(std::ceil(std::sqrt(static_cast<float>(box_count))));
+    const auto grid_offset = static_cast<float>(grid_size) * spacing * 0.5f;
+
+    for (auto i = 0u; i < box_count; ++i)
+    {
+        const auto x = static_cast<float>(i % grid_size) * spacing - grid_offset;
+        const auto z = static_cast<float>(i / grid_size) * spacing - grid_offset;
+
+        if (i % dynamic_every == 0u)
+        {
+            pm.add_dynamic_rigid_body({half_extent, half_extent, half_extent}, {x, 10.0f, z}, 1.0f);
+        }
+        else
+        {
+            pm.add_static_rigid_body({half_extent, half_extent, half_extent}, {x, 0.0f, z});
+        }
+    }
+}
+
+/**
+ * Add a ground plane and dynamic debris scattered through a tall column above it, so the timed ticks cover boxes
+ * falling, landing and piling up.
+ *
+ * @param pm
+ *   The PhysicsManager to add boxes to.
+ *
+ * @param box_count
+ *   Total number of boxes to add.
+ */
+void add_debris_rain(bab::PhysicsManager &pm, std::uint32_t box_count)
+{
+    constexpr auto half_extent = 0.25f;
+    constexpr auto spacing = 1.5f;
+    constexpr auto layer_size = 20u;
+
+    const auto grid_offset = static_cast<float>(layer_size) * spacing * 0.5f;
+
+    pm.add_static_rigid_body({grid_offset + spacing, 1.0f, grid_offset + spacing}, {0.0f, -1.0f, 0.0f});
+
+    for (auto i = 0u; i < box_count; ++i)
+    {
+        const auto cell = i % (layer_size * layer_size);
+        const auto layer = i / (layer_size * layer_size);
+
+        // stagger alternate layers so debris doesn't land in neat columns
+        const auto stagger = (layer % 2u == 0u) ? 0.0f : spacing * 0.5f;
+
+        const bab::Vector3 position{
+            static_cast<float>(cell % layer_size) * spacing - grid_offset + stagger,
+            5.0f + static_cast<float>(layer) * spacing,
+            static_cast<float>(cell / layer_size) * spacing - grid_offset + stagger};
+
+        pm.add_dynamic_rigid_body({half_extent, half_extent, half_extent}, position, 0.1f);
+    }
+}
+
+/**
+ * Add box stacks with a per body collision callback registered on every box.
+ *
+ * @param pm
+ *   The PhysicsManager to add boxes to.
+ *
+ * @param box_count
+ *   Total number of boxes to add.
+ */
+void add_watched_stacks(bab::PhysicsManager &pm, std::uint32_t box_count)
+{
+    for (const auto &box : add_stacked_boxes(pm, box_count, false))
+    {
+        pm.register_collision_callback(box, [] { return false; });
+    }
+}
+
+/**
+ * Add debris raining through a grid of trigger volumes, one trigger per ten boxes.
+ *
+ * @param pm
+ *   The PhysicsManager to add boxes to.
+ *
+ * @param box_count
+ *   Total number of boxes to add.
+ */
+void add_trigger_field(bab::PhysicsManager &pm, std::uint32_t box_count)
+{
+    constexpr auto trigger_every = 10u;
+    constexpr auto half_extent = 0.5f;
+
+    add_debris_rain(pm, box_count);
+
+    const auto trigger_count = std::max(box_count / trigger_every, 1u);
+    const auto grid_size = static_cast<std::uint32_t>(std::ceil(std::sqrt(static_cast<float>(trigger_count))));
+    const auto spacing = 30.0f / static_cast<float>(grid_size);
+
+    for (auto i = 0u; i < trigger_count; ++i)
+    {
+        const bab::Vector3 position{
+            static_cast<float>(i % grid_size) * spacing - 15.0f,
+            2.0f,
+            static_cast<float>(i / grid_size) * spacing - 15.0f};
+
+        pm.add_trigger_volume({half_extent, half_extent, half_extent}, position);
+    }
+
+    pm.register_trigger_event_callback([](std::span<const bab::TriggerEvent>) {});
+}
+
+/**
+ * Time how long a tick takes for a scene.
+ *
+ * @param config
+ *   Settings to simulate with.
+ *
+ * @param populate
+ *   Function to add the bodies of the scene.
+ *
+ * @param box_count
+ *   Number of boxes in the scene.
+ *
+ * @returns
+ *   Average time of a tick in milliseconds.
+ */
+double time_scene(
+    const bab::PhysicsConfig &config,
+    const std::function<void(bab::PhysicsManager &, std::uint32_t)> &populate,
+    std::uint32_t box_count)
+{
+    bab::PhysicsManager pm{config};
+    populate(pm, box_count);
+
+    for (auto i = 0u; i < warmup_ticks; ++i)
+    {
+        pm.update(tick_length);
+    }
+
+    const auto start = std::chrono::steady_clock::now();
+
+    for (auto i = 0u; i < timed_ticks; ++i)
+    {
+        pm.update(tick_length);
+    }
+
+    const auto end = std::chrono::steady_clock::now();
+
+    return std::chrono::duration<double, std::milli>(end - start).count() / timed_ticks;
+}
+
+/**
+ * Run every scenario at several sizes, printing ns/step, contacts/step and allocations/step as json so results can be
+ * compared between runs.
+ */
+void run_suite_benchmark()
+{
+    const std::tuple<std::string_view, void (*)(bab::PhysicsManager &, std::uint32_t)> scenes[] = {
+        {"stacks", add_box_stacks},
+        {"debris_rain", add_debris_rain},
+        {"watched_callbacks", add_watched_stacks},
+        {"triggers", add_trigger_field}};
+
+    std::cout << "[" << std::endl;
+
+    auto first = true;
+    for (const auto &[scene_name, populate] : scenes)
+    {
+        for (const auto box_count : {1000u, 4000u, 16000u})
+        {
+            bab::PhysicsManager pm{};
+            populate(pm, box_count);
+
+            auto contacts = std::uint64_t{0u};
+            pm.register_collision_event_callback([&contacts](std::span<const bab::CollisionEvent> events) {
+                contacts += static_cast<std::uint64_t>(std::ranges::count_if(
+                    events, [](const auto &event) { return event.type != bab::CollisionEventType::END; }));
+            });
+
+            for (auto i = 0u; i < warmup_ticks; ++i)
+            {
+                pm.update(tick_length);
+            }
+
+            contacts = 0u;
+            const auto allocations_before = allocation_count.load();
+            const auto start = std::chrono::steady_clock::now();
+
+            for (auto i = 0u; i < timed_ticks; ++i)
+            {
+                pm.update(tick_length);
+            }
+
+            const auto end = std::chrono::steady_clock::now();
+            const auto allocations = allocation_count.load() - allocations_before;
+
+            const auto ns_per_step = std::chrono::duration<double, std::nano>(end - start).count() / timed_ticks;
+
+            std::cout << (first ? "  " : ",\n  ") << "{\"scene\": \"" << scene_name << "\", \"boxes\": " << box_count
+                      << ", \"ns_per_step\": " << ns_per_step
+                      << ", \"contacts_per_step\": " << static_cast<double>(contacts) / timed_ticks
+                      << ", \"allocations_per_step\": " << static_cast<double>(allocations) / timed_ticks << "}";
+            first = false;
+        }
+    }
+
+    std::cout << std::endl << "]" << std::endl;
+}
+
+/**
+ * Compare tick times across thread counts for stacked boxes.
+ */
+void run_thread_benchmark()
+{
+    const auto max_threads = std::max(std::thread::hardware_concurrency(), 1u);
+
+    // double the thread count each run, always finishing on the full machine
+    std::vector<std::uint32_t> thread_counts{};
+    for (auto threads = 1u; threads < max_threads; threads *= 2u)
+    {
+        thread_counts.push_back(threads);
+    }
+    thread_counts.push_back(max_threads);
+
+    std::cout << "boxes,threads,ms_per_step" << std::endl;
+
+    for (const auto box_count : {1000u, 10000u, 50000u})
+    {
+        for (const auto thread_count : thread_counts)
+        {
+            bab::PhysicsConfig config{};
+            config.thread_count = thread_count;
+
+            std::cout << box_count << "," << thread_count << "," << time_scene(config, add_box_stacks, box_count)
+                      << std::endl;
+        }
+    }
+}
+
+/**
+ * Compare tick times across broadphases for stacked boxes and mostly static levels.
+ */
+void run_broadphase_benchmark()
+{
+    const std::tuple<std::string_view, bab::BroadphaseType> broadphases[] = {
+        {"dbvt", bab::BroadphaseType::DBVT},
+        {"axis_sweep", bab::BroadphaseType::AXIS_SWEEP},
+        {"axis_sweep_32", bab::BroadphaseType::AXIS_SWEEP_32}};
+
+    const std::tuple<std::string_view, void (*)(bab::PhysicsManager &, std::uint32_t)> scenes[] = {
+        {"stacks", add_box_stacks}, {"static_level", add_static_level}};
+
+    std::cout << "scene,broadphase,boxes,ms_per_step" << std::endl;
+
+    for (const auto &[scene_name, populate] : scenes)
+    {
+        for (const auto box_count : {1000u, 10000u, 50000u})
+        {
+            for (const auto &[broadphase_name, broadphase] : broadphases)
+            {
+                // bounds comfortably enclosing both scenes at every size, plus room for the stacks' ground box
+                bab::PhysicsConfig config{};
+                config.broadphase = broadphase;
+                config.world_min = {-400.0f, -50.0f, -400.0f};
+                config.world_max = {400.0f, 100.0f, 400.0f};
+                config.max_broadphase_objects = box_count + 1u;
+
+                std::cout << scene_name << "," << broadphase_name << "," << box_count << ","
+                          << time_scene(config, populate, box_count) << std::endl;
+            }
+        }
+    }
+}
+
+/**
+ * Compare tick times across collision configurations for large crate stacks on a box and on a plane.
+ */
+void run_collision_benchmark()
+{
+    const std::tuple<std::string_view, bab::CollisionConfigurationType> configurations[] = {
+        {"default", bab::CollisionConfigurationType::DEFAULT},
+        {"box_plane", bab::CollisionConfigurationType::BOX_PLANE}};
+
+    const std::tuple<std::string_view, void (*)(bab::PhysicsManager &, std::uint32_t)> scenes[] = {
+        {"stacks", add_box_stacks}, {"plane_stacks", add_plane_stacks}};
+
+    std::cout << "scene,collision_configuration,boxes,ms_per_step" << std::endl;
+
+    for (const auto &[scene_name, populate] : scenes)
+    {
+        for (const auto box_count : {1000u, 10000u, 50000u})
+        {
+            for (const auto &[configuration_name, configuration] : configurations)
+            {
+                bab::PhysicsConfig config{};
+                config.collision_configuration = configuration;
+
+                std::cout << scene_name << "," << configuration_name << "," << box_count << ","
+                          << time_scene(config, populate, box_count) << std::endl;
+            }
+        }
+    }
+}
+
+/**
+ * Compare adding boxes one at a time with adding them in a single batch.
+ */
+void run_spawn_benchmark()
+{
+    std::cout << "method,boxes,ms" << std::endl;
+
+    for (const auto box_count : {10000u, 100000u})
+    {
+        // a cube of boxes that are all in contact, so the broadphase has plenty of pairs to find
+        const auto side = static_cast<std::uint32_t>(std::ceil(std::cbrt(static_cast<float>(box_count))));
+
+        std::vector<bab::BoxRigidBodyDesc> descs{};
+        descs.reserve(box_count);
+
+        for (auto i = 0u; i < box_count; ++i)
+        {
+            const bab::Vector3 position{
+                static_cast<float>(i % side),
+                static_cast<float>((i / side) % side),
+                static_cast<float>(i / (side * side))};
+
+            descs.push_back({{0.5f, 0.5f, 0.5f}, position, 1.0f});
+        }
+
+        {
+            bab::PhysicsManager pm{};
+
+            const auto start = std::chrono::steady_clock::now();
+            for (const auto &desc : descs)
+            {
+                pm.add_dynamic_rigid_body(desc.half_extent, desc.position, desc.mass);
+            }
+            pm.update(tick_length);
+            const auto end = std::chrono::steady_clock::now();
+
+            std::cout << "individual," << box_count << ","
+                      << std::chrono::duration<double, std::milli>(end - start).count() << std::endl;
+        }
+
+        {
+            bab::PhysicsManager pm{};
+
+            const auto start = std::chrono::steady_clock::now();
+            pm.add_dynamic_rigid_bodies(descs);
+            pm.update(tick_length);
+            const auto end = std::chrono::steady_clock::now();
+
+            std::cout << "batch," << box_count << "," << std::chrono::duration<double, std::milli>(end - start).count()
+                      << std::endl;
+        }
+    }
+}
+
+}
+
+int main(int argc, char **argv)
+{
+    // must happen before bullet allocates anything
+    ::btAlignedAllocSetCustom(counting_bullet_alloc, counting_bullet_free);
+
+    // the json suite is the default so results can be tracked between runs, the csv comparisons are run by name
+    const std::string_view benchmark = argc > 1 ? argv[1] : "suite";
+
+    if (benchmark == "suite")
+    {
+        run_suite_benchmark();
+    }
+    else if (benchmark == "threads")
+    {
+        run_thread_benchmark();
+    }
+    else if (benchmark == "broadphase")
+    {
+        run_broadphase_benchmark();
+    }
+    else if (benchmark == "collision")
+    {
+        run_collision_benchmark();
+    }
+    else if (benchmark == "spawn")
+    {
+        run_spawn_benchmark();
+    }
+    else
+    {
+        std::cerr << "unknown benchmark " << benchmark << ", expected suite, threads, broadphase, collision or spawn"
+                  << std::endl;
+        return 1;
+    }
+
+    return 0;
+}
+
+void *operator new(std::size_t size)
+{
+    allocation_count.fetch_add(1u, std::memory_order_relaxed);
+
+    if (auto *memory = std::malloc(size == 0u ? 1u : size); memory != nullptr)
+    {
+        return memory;
+    }
+
+    throw std::bad_alloc{};
+}
+
+void operator delete(void *memory) noexcept
+{
+    std::free(memory);
+}
+
+void operator delete(void *memory, std::size_t) noexcept
+{
+    std::free(memory);
+}
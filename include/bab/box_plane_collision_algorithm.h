@@ -0,0 +1,108 @@
+#pragma once
+
+#include "BulletCollision/BroadphaseCollision/btCollisionAlgorithm.h"
+#include "BulletCollision/CollisionDispatch/btActivatingCollisionAlgorithm.h"
+#include "BulletCollision/CollisionDispatch/btCollisionCreateFunc.h"
+#include "BulletCollision/CollisionDispatch/btCollisionObjectWrapper.h"
+#include "BulletCollision/CollisionDispatch/btManifoldResult.h"
+#include "BulletCollision/NarrowPhaseCollision/btPersistentManifold.h"
+#include "LinearMath/btScalar.h"
+
+namespace bab
+{
+
+/**
+ * Box static plane collision algorithm which tests the eight corners of the box directly against the plane. Bullet's
+ * generic convex plane algorithm finds one point and perturbs the box to find more, which is both slower and gives
+ * less stable resting contacts for a box lying flat.
+ */
+class BoxPlaneCollisionAlgorithm : public ::btActivatingCollisionAlgorithm
+{
+  public:
+    /**
+     * Construct a new BoxPlaneCollisionAlgorithm.
+     *
+     * @param construction_info
+     *   Bullet's construction info, holds the dispatcher.
+     *
+     * @param body0_wrap
+     *   First object, the box unless swapped.
+     *
+     * @param body1_wrap
+     *   Second object, the plane unless swapped.
+     *
+     * @param swapped
+     *   True if body0_wrap is the plane and body1_wrap the box.
+     */
+    BoxPlaneCollisionAlgorithm(
+        const ::btCollisionAlgorithmConstructionInfo &construction_info,
+        const ::btCollisionObjectWrapper *body0_wrap,
+        const ::btCollisionObjectWrapper *body1_wrap,
+        bool swapped);
+
+    /**
+     * BoxPlaneCollisionAlgorithm specific cleanup.
+     */
+    ~BoxPlaneCollisionAlgorithm() override;
+
+    /**
+     * Find the contacts between a box and a plane and add them to the manifold.
+     *
+     * @param body0_wrap
+     *   First object.
+     *
+     * @param body1_wrap
+     *   Second object.
+     *
+     * @param dispatch_info
+     *   Settings for the current dispatch.
+     *
+     * @param result
+     *   Result to add contacts to.
+     */
+    void processCollision(
+        const ::btCollisionObjectWrapper *body0_wrap,
+        const ::btCollisionObjectWrapper *body1_wrap,
+        const ::btDispatcherInfo &dispatch_info,
+        ::btManifoldResult *result) override;
+
+    /**
+     * Continuous collision is not supported for boxes, so this always reports no impact.
+     *
+     * @returns
+     *   Time of impact, always 1.
+     */
+    ::btScalar calculateTimeOfImpact(
+        ::btCollisionObject *body0,
+        ::btCollisionObject *body1,
+        const ::btDispatcherInfo &dispatch_info,
+        ::btManifoldResult *result) override;
+
+    /**
+     * Get the manifolds owned by the algorithm.
+     *
+     * @param manifolds
+     *   Array to add the manifolds to.
+     */
+    void getAllContactManifolds(::btManifoldArray &manifolds) override;
+
+    /**
+     * Factory bullet uses to create the algorithm for a box plane pair.
+     */
+    struct CreateFunc : public ::btCollisionAlgorithmCreateFunc
+    {
+        ::btCollisionAlgorithm *CreateCollisionAlgorithm(
+            ::btCollisionAlgorithmConstructionInfo &construction_info,
+            const ::btCollisionObjectWrapper *body0_wrap,
+            const ::btCollisionObjectWrapper *body1_wrap) override;
+    };
+
+  private:
+    /** Manifold the contacts are stored in, null if the pair does not need collision. */
+    ::btPersistentManifold *manifold_;
+
+    /** True if the plane is the first object. */
+    bool swapped_;
+};
+
+}
@@ -0,0 +1,45 @@
+#pragma once
+
+#include "box_plane_collision_algorithm.h"
+
+#include "BulletCollision/CollisionDispatch/btCollisionCreateFunc.h"
+#include "BulletCollision/CollisionDispatch/btDefaultCollisionConfiguration.h"
+
+namespace bab
+{
+
+/**
+ * Collision configuration which swaps in a box specialised algorithm for box static plane pairs, every other pair
+ * uses bullet's default algorithms. Box box pairs already go to bullet's own separating axis and clipping routine.
+ */
+class BoxPlaneCollisionConfiguration : public ::btDefaultCollisionConfiguration
+{
+  public:
+    /**
+     * Construct a new BoxPlaneCollisionConfiguration.
+     */
+    BoxPlaneCollisionConfiguration();
+
+    /**
+     * Get the factory for the algorithm used to collide two shape types.
+     *
+     * @param proxy_type0
+     *   Shape type of the first object.
+     *
+     * @param proxy_type1
+     *   Shape type of the second object.
+     *
+     * @returns
+     *   Algorithm factory.
+     */
+    ::btCollisionAlgorithmCreateFunc *getCollisionAlgorithmCreateFunc(int proxy_type0, int proxy_type1) override;
+
+  private:
+    /** Factory for box plane pairs. */
+    BoxPlaneCollisionAlgorithm::CreateFunc box_plane_create_func_;
+
+    /** Factory for plane box pairs. */
+    BoxPlaneCollisionAlgorithm::CreateFunc plane_box_create_func_;
+};
+
+}
@@ -0,0 +1,23 @@
+#pragma once
+
+#include "vector3.h"
+
+namespace bab
+{
+
+/**
+ * Description of a dynamic box rigid body, used to add many rigid bodies in one call.
+ */
+struct BoxRigidBodyDesc
+{
+    /** The half extents of the box. */
+    Vector3 half_extent;
+
+    /** The position in world space of the rigid body. */
+    Vector3 position;
+
+    /** The mass of the rigid body. */
+    float mass;
+};
+
+}
@@ -0,0 +1,45 @@
+#pragma once
+
+#include "rigid_body.h"
+#include "vector3.h"
+
+namespace bab
+{
+
+/**
+ * The kind of change a CollisionEvent describes.
+ */
+enum class CollisionEventType
+{
+    /** The two bodies started touching this tick. */
+    BEGIN,
+
+    /** The two bodies were touching last tick and still are. */
+    PERSIST,
+
+    /** The two bodies were touching last tick but no longer are. */
+    END
+};
+
+/**
+ * Describes a change in contact between two rigid bodies during a physics tick.
+ */
+struct CollisionEvent
+{
+    /** What happened between the two bodies. */
+    CollisionEventType type;
+
+    /** The first body in the contact. */
+    RigidBody body_a;
+
+    /** The second body in the contact. */
+    RigidBody body_b;
+
+    /** World position of the deepest contact point, for END events this is the last known contact point. */
+    Vector3 point;
+
+    /** Total impulse the solver applied to resolve the contact, always zero for END events. */
+    float impulse;
+};
+
+}
@@ -0,0 +1,108 @@
+#pragma once
+
+#include <array>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace bab
+{
+
+/**
+ * Which collision layers a rigid body is in and which it collides with. Two rigid bodies only collide if each is in a
+ * layer the other collides with.
+ */
+struct CollisionFilter
+{
+    /** Bit mask of the layers the rigid body is in. */
+    std::uint32_t group;
+
+    /** Bit mask of the layers the rigid body collides with. */
+    std::uint32_t mask;
+
+    bool operator==(const CollisionFilter &) const = default;
+};
+
+/**
+ * Table of named collision layers and which layers collide with each other, used to build CollisionFilters. The first
+ * layers match bullet's built in filter groups: "default", "static", "kinematic", "debris", "sensor" and "character".
+ * Every layer collides with every other layer except static with static.
+ */
+class CollisionLayers
+{
+  public:
+    /** Maximum number of layers, one per bit of a filter. */
+    static constexpr auto max_layers = 32u;
+
+    /**
+     * Construct a new CollisionLayers with the built in layers.
+     */
+    CollisionLayers();
+
+    /**
+     * Add a new layer which collides with every existing layer.
+     *
+     * @param name
+     *   Name of the layer, must not already exist.
+     *
+     * @returns
+     *   Bit for the layer.
+     */
+    std::uint32_t add(const std::string &name);
+
+    /**
+     * Get the bit for a layer.
+     *
+     * @param name
+     *   Name of the layer, must exist.
+     *
+     * @returns
+     *   Bit for the layer.
+     */
+    std::uint32_t layer(const std::string &name) const;
+
+    /**
+     * Set whether two layers collide with each other, this only affects filters created after the call.
+     *
+     * @param layer_a
+     *   Name of the first layer, must exist.
+     *
+     * @param layer_b
+     *   Name of the second layer, must exist, may be the same as layer_a.
+     *
+     * @param collides
+     *   Whether rigid bodies in the layers should collide.
+     */
+    void set_collides(const std::string &layer_a, const std::string &layer_b, bool collides);
+
+    /**
+     * Get the filter for a rigid body in a layer.
+     *
+     * @param name
+     *   Name of the layer, must exist.
+     *
+     * @returns
+     *   Filter putting a rigid body in the layer and colliding with every layer the layer collides with.
+     */
+    CollisionFilter filter(const std::string &name) const;
+
+  private:
+    /**
+     * Get the index of a layer.
+     *
+     * @param name
+     *   Name of the layer, must exist.
+     *
+     * @returns
+     *   Index of the layer.
+     */
+    std::uint32_t index_of(const std::string &name) const;
+
+    /** Names of the layers, in bit order. */
+    std::vector<std::string> names_;
+
+    /** Bit mask of the layers each layer collides with. */
+    std::array<std::uint32_t, max_layers> masks_;
+};
+
+}
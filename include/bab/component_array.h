@@ -0,0 +1,216 @@
+#pragma once
+
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <span>
+#include <utility>
+#include <vector>
+
+namespace bab
+{
+
+/**
+ * Densely packed storage for one type of component, keyed by entity index. Components are kept contiguous in memory
+ * so systems can stream through them, removing a component moves the last one into the gap so order is not stable.
+ */
+template <class T>
+class ComponentArray
+{
+  public:
+    /**
+     * Construct a new ComponentArray.
+     */
+    ComponentArray()
+        : components_()
+        , entities_()
+        , dense_()
+    {
+    }
+
+    /**
+     * Add a component for an entity, the entity must not already have one.
+     *
+     * @param entity
+     *   Index of the entity.
+     *
+     * @param component
+     *   The component to add.
+     *
+     * @returns
+     *   Reference to the stored component, valid until the array is next modified.
+     */
+    T &insert(std::uint32_t entity, T component)
+    {
+        assert(!contains(entity));
+
+        if (entity >= dense_.size())
+        {
+            dense_.resize(entity + 1u, absent);
+        }
+
+        dense_[entity] = static_cast<std::uint32_t>(components_.size());
+        entities_.push_back(entity);
+
+        return components_.emplace_back(std::move(component));
+    }
+
+    /**
+     * Remove the component of an entity, does nothing if the entity has none.
+     *
+     * @param entity
+     *   Index of the entity.
+     */
+    void erase(std::uint32_t entity)
+    {
+        if (!contains(entity))
+        {
+            return;
+        }
+
+        const auto index = dense_[entity];
+        const auto last = static_cast<std::uint32_t>(components_.size() - 1u);
+
+        // fill the gap with the last component so the array stays packed
+        if (index != last)
+        {
+            components_[index] = std::move(components_[last]);
+            entities_[index] = entities_[last];
+            dense_[entities_[index]] = index;
+        }
+
+        components_.pop_back();
+        entities_.pop_back();
+        dense_[entity] = absent;
+    }
+
+    /**
+     * Check if an entity has a component in this array.
+     *
+     * @param entity
+     *   Index of the entity.
+     *
+     * @returns
+     *   True if the entity has a component, otherwise false.
+     */
+    bool contains(std::uint32_t entity) const
+    {
+        return (entity < dense_.size()) && (dense_[entity] != absent);
+    }
+
+    /**
+     * Get the component of an entity, the entity must have one.
+     *
+     * @param entity
+     *   Index of the entity.
+     *
+     * @returns
+     *   Reference to the component, valid until the array is next modified.
+     */
+    T &get(std::uint32_t entity)
+    {
+        assert(contains(entity));
+        return components_[dense_[entity]];
+    }
+
+    /**
+     * Get the component of an entity, the entity must have one.
+     *
+     * @param entity
+     *   Index of the entity.
+     *
+     * @returns
+     *   Reference to the component, valid until the array is next modified.
+     */
+    const T &get(std::uint32_t entity) const
+    {
+        assert(contains(entity));
+        return components_[dense_[entity]];
+    }
+
+    /**
+     * Get the component of an entity if it has one.
+     *
+     * @param entity
+     *   Index of the entity.
+     *
+     * @returns
+     *   Pointer to the component, or nullptr if the entity has none.
+     */
+    T *find(std::uint32_t entity)
+    {
+        return contains(entity) ? &components_[dense_[entity]] : nullptr;
+    }
+
+    /**
+     * Get all components, packed together.
+     *
+     * @returns
+     *   Every component in the array, in the same order as entities().
+     */
+    std::span<T> components()
+    {
+        return components_;
+    }
+
+    /**
+     * Get all components, packed together.
+     *
+     * @returns
+     *   Every component in the array, in the same order as entities().
+     */
+    std::span<const T> components() const
+    {
+        return components_;
+    }
+
+    /**
+     * Get the entity each component belongs to.
+     *
+     * @returns
+     *   Entity index of each component, in the same order as components().
+     */
+    std::span<const std::uint32_t> entities() const
+    {
+        return entities_;
+    }
+
+    /**
+     * Get the number of components in the array.
+     *
+     * @returns
+     *   Number of components.
+     */
+    std::size_t size() const
+    {
+        return components_.size();
+    }
+
+    /**
+     * Reserve space for a number of components, so adding up to that many does not allocate.
+     *
+     * @param count
+     *   Total number of components to reserve space for.
+     */
+    void reserve(std::size_t count)
+    {
+        components_.reserve(count);
+        entities_.reserve(count);
+    }
+
+  private:
+    /** Marker in dense_ for entities with no component. */
+    static constexpr auto absent = std::numeric_limits<std::uint32_t>::max();
+
+    /** Packed components. */
+    std::vector<T> components_;
+
+    /** Entity index of each component in components_. */
+    std::vector<std::uint32_t> entities_;
+
+    /** Index into components_ for each entity index, or absent. */
+    std::vector<std::uint32_t> dense_;
+};
+
+}
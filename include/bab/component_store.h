@@ -0,0 +1,190 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include <vector>
+
+#include "audio_clip.h"
+#include "component_array.h"
+#include "render_entity.h"
+#include "rigid_body.h"
+#include "scene_entity.h"
+#include "thread_pool.h"
+#include "transform.h"
+
+namespace bab
+{
+
+/**
+ * Storage for entities and their components. Each component type lives in its own packed array, so systems which only
+ * need one or two components stream through memory instead of chasing pointers. Entities which are given the same
+ * components in the same order keep their components at the same position in every array.
+ */
+class ComponentStore
+{
+  public:
+    /**
+     * Construct a new ComponentStore.
+     *
+     * @param thread_pool
+     *   Optional pool to split for_each_chunk() across, if nullptr systems run on the calling thread. The pool must not
+     *   be used by another thread while a system runs.
+     */
+    ComponentStore(ThreadPool *thread_pool = nullptr);
+
+    /**
+     * Create a new entity with no components.
+     *
+     * @returns
+     *   Handle to the new entity.
+     */
+    SceneEntity create();
+
+    /**
+     * Destroy an entity and all its components, does nothing if the entity is already destroyed.
+     *
+     * @param entity
+     *   The entity to destroy.
+     */
+    void destroy(const SceneEntity &entity);
+
+    /**
+     * Check if an entity has not been destroyed.
+     *
+     * @param entity
+     *   The entity to check.
+     *
+     * @returns
+     *   True if the entity is alive, otherwise false.
+     */
+    bool is_alive(const SceneEntity &entity) const;
+
+    /**
+     * Get the handle of a live entity from its index, for use with the entity indices handed to systems.
+     *
+     * @param index
+     *   Index of a live entity.
+     *
+     * @returns
+     *   Handle to the entity.
+     */
+    SceneEntity entity(std::uint32_t index) const;
+
+    /**
+     * Get the number of live entities.
+     *
+     * @returns
+     *   Number of live entities.
+     */
+    std::size_t size() const;
+
+    /**
+     * Get the world transform components.
+     *
+     * @returns
+     *   Transform array.
+     */
+    ComponentArray<Transform> &transforms();
+
+    /**
+     * Get the physics components.
+     *
+     * @returns
+     *   Rigid body array.
+     */
+    ComponentArray<RigidBody> &rigid_bodies();
+
+    /**
+     * Get the render components.
+     *
+     * @returns
+     *   Render entity array.
+     */
+    ComponentArray<RenderEntity> &render_entities();
+
+    /**
+     * Get the audio emitter components, the clip each entity plays.
+     *
+     * @returns
+     *   Audio emitter array.
+     */
+    ComponentArray<const AudioClip *> &audio_emitters();
+
+    /**
+     * Get the user data components, free for the game to use.
+     *
+     * @returns
+     *   User data array.
+     */
+    ComponentArray<std::uint64_t> &user_data();
+
+    /**
+     * Run a system over every component in an array, split into chunks across the thread pool. The system is called
+     * as system(std::span<const std::uint32_t> entities, std::span<T> components) for each chunk and may be called
+     * from several threads at once, so it may freely modify the components it is given and read or modify components
+     * of the same entities in other arrays, but must not add or remove components.
+     *
+     * @param components
+     *   The array to iterate.
+     *
+     * @param chunk_size
+     *   Number of components to hand to a thread at a time.
+     *
+     * @param system
+     *   Function to call for each chunk.
+     */
+    template <class T, class System>
+    void for_each_chunk(ComponentArray<T> &components, std::int32_t chunk_size, const System &system)
+    {
+        const auto entities = components.entities();
+        const auto data = components.components();
+
+        const auto run_chunk = [&](std::int32_t begin, std::int32_t end) {
+            const auto offset = static_cast<std::size_t>(begin);
+            const auto count = static_cast<std::size_t>(end - begin);
+            system(entities.subspan(offset, count), data.subspan(offset, count));
+        };
+
+        const auto size = static_cast<std::int32_t>(data.size());
+
+        if (thread_pool_ != nullptr)
+        {
+            thread_pool_->parallel_for(0, size, chunk_size, run_chunk);
+        }
+        else if (size != 0)
+        {
+            run_chunk(0, size);
+        }
+    }
+
+  private:
+    /** Pool to run systems on, may be nullptr. */
+    ThreadPool *thread_pool_;
+
+    /** Generation of each entity index, incremented when the entity is destroyed. */
+    std::vector<std::uint32_t> generations_;
+
+    /** Whether each entity index is in use. */
+    std::vector<bool> alive_;
+
+    /** Indices of destroyed entities available for reuse. */
+    std::vector<std::uint32_t> free_indices_;
+
+    /** World transform components. */
+    ComponentArray<Transform> transforms_;
+
+    /** Physics components. */
+    ComponentArray<RigidBody> rigid_bodies_;
+
+    /** Render components. */
+    ComponentArray<RenderEntity> render_entities_;
+
+    /** Audio emitter components. */
+    ComponentArray<const AudioClip *> audio_emitters_;
+
+    /** User data components. */
+    ComponentArray<std::uint64_t> user_data_;
+};
+
+}
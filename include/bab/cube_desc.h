@@ -0,0 +1,31 @@
+#pragma once
+
+#include <string>
+
+#include "vector3.h"
+
+namespace bab
+{
+
+/**
+ * Description of a cube, used to add many cubes to a scene in one call.
+ */
+struct CubeDesc
+{
+    /** World position of the cube. */
+    Vector3 position;
+
+    /** The scale of the cube (x, y and z direction). */
+    float scale;
+
+    /** The name of the material to use. */
+    std::string material_name;
+
+    /** The mass of the cube's rigid body, ignored by the GraphicsManager. */
+    float mass;
+
+    /** Whether the SceneManager draws the cube with hardware instancing, ignored by the GraphicsManager. */
+    bool instanced = false;
+};
+
+}
@@ -0,0 +1,31 @@
+#pragma once
+
+#include <cstdint>
+
+namespace bab
+{
+
+/**
+ * Settings used when constructing a GraphicsManager.
+ */
+struct GraphicsConfig
+{
+    /**
+     * Number of threads to run frame tasks on, including the render thread. One runs every task on the render thread.
+     */
+    std::uint32_t job_thread_count = 1u;
+
+    /**
+     * Render with Ogre's software render system into an offscreen target instead of opening a window, for machines
+     * with no GPU or display. Shader based features such as PSSM shadows and instancing are unavailable.
+     */
+    bool headless = false;
+
+    /** Width in pixels of the headless render target. */
+    std::uint32_t width = 1280u;
+
+    /** Height in pixels of the headless render target. */
+    std::uint32_t height = 720u;
+};
+
+}
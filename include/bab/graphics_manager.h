@@ -1,18 +1,35 @@
 #pragma once
 
+#include <cstddef>
+#include <cstdint>
 #include <functional>
+#include <map>
+#include <memory>
+#include <span>
 #include <string>
+#include <unordered_set>
+#include <utility>
 #include <vector>
 
 #include "colour.h"
+#include "cube_desc.h"
 #include "degree.h"
+#include "graphics_config.h"
+#include "instancing_technique.h"
+#include "job_system.h"
 #include "manual_object.h"
+#include "mesh_lod_settings.h"
 #include "quaternion.h"
 #include "render_entity.h"
+#include "shadow_config.h"
+#include "task_graph.h"
 #include "vector3.h"
 
 #include "Ogre.h"
 #include "OgreApplicationContext.h"
+#include "OgreInstanceManager.h"
+#include "OgreMeshLodGenerator.h"
+#include "OgreRTShaderSystem.h"
 
 namespace bab
 {
@@ -25,8 +42,12 @@ class GraphicsManager : private ::OgreBites::ApplicationContext, ::OgreBites::In
   public:
     /**
      * Construct a new GraphicsManager.
+     *
+     * @param config
+     *   Settings for rendering, throws std::runtime_error if no render window could be created, such as when running
+     *   headless without the Tiny render system.
      */
-    GraphicsManager();
+    GraphicsManager(const GraphicsConfig &config = {});
 
     /**
      * GraphicsManager specific cleanup.
@@ -83,6 +104,85 @@ class GraphicsManager : private ::OgreBites::ApplicationContext, ::OgreBites::In
         bool casts_shadows,
         const std::string &material_name);
 
+    /**
+     * Set how shadows are rendered, replacing any previous settings. Defaults to stencil shadows.
+     *
+     * @param config
+     *   The shadow settings.
+     */
+    void set_shadows(const ShadowConfig &config);
+
+    /**
+     * Set the levels of detail generated for meshes added after this call with add_mesh() or add_static_mesh().
+     * Generated meshes are cached next to the original mesh file, so they are only generated again when the mesh or
+     * settings change.
+     *
+     * @param settings
+     *   The level of detail settings.
+     */
+    void set_mesh_lod(const MeshLodSettings &settings);
+
+    /**
+     * Add a mesh which never moves to the scene. Static meshes are merged into batched regions by
+     * build_static_geometry() and are not visible until it is called.
+     *
+     * @param mesh_name
+     *   Name of mesh to load, must exist in a resource location.
+     *
+     * @param position
+     *   The world position of the mesh.
+     *
+     * @param orientation
+     *   The world orientation of the mesh.
+     *
+     * @param casts_shadows
+     *   Whether the model can cast a shadow.
+     */
+    void add_static_mesh(
+        const std::string &mesh_name,
+        const Vector3 &position,
+        const Quaternion &orientation,
+        bool casts_shadows);
+
+    /**
+     * Add a plane (XZ) which never moves to the scene, see add_static_mesh().
+     *
+     * @param width
+     *   The width of the mesh (x axis).
+     *
+     * @param height
+     *   The height of the mesh (z axis).
+     *
+     * @param x_segments
+     *   How many segments make up the plane in the x direction.
+     *
+     * @param z_segments
+     *   How many segments make up the plane in the z direction.
+     *
+     * @param casts_shadows
+     *   Whether the model can cast a shadow.
+     *
+     * @param material_name
+     *   The name of the material to add to the plane.
+     */
+    void add_static_plane(
+        float width,
+        float height,
+        std::uint32_t x_segments,
+        std::uint32_t z_segments,
+        bool casts_shadows,
+        const std::string &material_name);
+
+    /**
+     * Merge every static mesh into batched regions, meshes in the same region with the same material are drawn
+     * together. Should be called once after loading, calling again rebuilds every region including meshes added
+     * since.
+     *
+     * @param region_size
+     *   Size of each region, larger regions mean fewer batches but coarser culling.
+     */
+    void build_static_geometry(const Vector3 &region_size);
+
     /**
      * Add a new named material to the engine which simply applies a texture.
      *
@@ -111,6 +211,62 @@ class GraphicsManager : private ::OgreBites::ApplicationContext, ::OgreBites::In
      */
     RenderEntity add_cube(const Vector3 &position, float scale, const std::string &material_name);
 
+    /**
+     * Add many cubes to the scene at once. The mesh and each distinct material are only looked up once for the whole
+     * batch, rather than once per cube.
+     *
+     * @param descs
+     *   Descriptions of the cubes to add.
+     *
+     * @returns
+     *   Newly added entities, in the same order as descs.
+     */
+    std::vector<RenderEntity> add_cubes(std::span<const CubeDesc> descs);
+
+    /**
+     * Add a new cube drawn with hardware instancing, all instanced cubes with the same material share a handful of draw
+     * calls no matter how many there are. The returned entity has no scene node, so moving it writes straight to its
+     * instance.
+     *
+     * @param position
+     *   World position of the cube.
+     *
+     * @param scale
+     *   The scale of the cube (x, y and z direction).
+     *
+     * @param material_name
+     *   The name of the material to add, with HARDWARE_VTF it must provide a vertex shader that reads the instance
+     *   texture. With HARDWARE_BASIC the cube is drawn with an instanced copy of the material, so the material itself
+     *   can still be used by entities which are not instanced.
+     *
+     * @param technique
+     *   The instancing technique to draw the cube with.
+     *
+     * @returns
+     *   Newly added entity.
+     */
+    RenderEntity add_instanced_cube(
+        const Vector3 &position,
+        float scale,
+        const std::string &material_name,
+        InstancingTechnique technique = InstancingTechnique::HARDWARE_BASIC);
+
+    /**
+     * Add many cubes drawn with hardware instancing at once, see add_instanced_cube().
+     *
+     * @param descs
+     *   Descriptions of the cubes to add.
+     *
+     * @param technique
+     *   The instancing technique to draw the cubes with.
+     *
+     * @returns
+     *   Newly added entities, in the same order as descs.
+     */
+    std::vector<RenderEntity> add_instanced_cubes(
+        std::span<const CubeDesc> descs,
+        InstancingTechnique technique = InstancingTechnique::HARDWARE_BASIC);
+
     /**
      * Add a new manual object to the scene.
      *
@@ -181,27 +337,133 @@ class GraphicsManager : private ::OgreBites::ApplicationContext, ::OgreBites::In
     void set_sky_dome(const std::string &material_name, float curvature, float tiling);
 
     /**
-     * Register a callback, which will get fired on frame start.
+     * Add a task to run every frame before rendering. Tasks run once all their dependencies have finished, those with
+     * no ordering between them run in parallel. Dependencies which name tasks that were never added are ignored.
+     *
+     * @param name
+     *   Unique name of the task, for other tasks to depend on.
+     *
+     * @param dependencies
+     *   Names of the tasks which must finish before this one starts.
+     *
+     * @param task
+     *   The task to run, it is passed the time in seconds since the last frame.
+     *
+     * @param main_thread
+     *   Whether the task must run on the render thread, any task touching the scene graph must.
+     */
+    void add_frame_task(
+        const std::string &name,
+        const std::vector<std::string> &dependencies,
+        std::function<void(float)> task,
+        bool main_thread = true);
+
+    /**
+     * Register a callback, which will get fired on frame start. Callbacks run on the render thread, in the order they
+     * were registered, but are not ordered against frame tasks.
      *
      * @param callback
-     *   The callback to register.
+     *   The callback to register, it is passed the time in seconds since the last frame.
      */
-    void register_frame_start_callback(std::function<void()> callback);
+    void register_frame_start_callback(std::function<void(float)> callback);
 
     /**
      * Register a callback, which will get fired on frame end.
      *
      * @param callback
-     *   The callback to register.
+     *   The callback to register, it is passed the time in seconds since the last frame.
+     */
+    void register_frame_end_callback(std::function<void(float)> callback);
+
+    /**
+     * Get the number of draw calls issued to render the last frame.
+     *
+     * @returns
+     *   Number of draw calls.
      */
-    void register_frame_end_callback(std::function<void()> callback);
+    std::size_t draw_call_count() const;
+
+    /**
+     * Get the job system frame tasks run on, other work can be submitted to it to use spare cores.
+     *
+     * @returns
+     *   The job system.
+     */
+    JobSystem &job_system();
 
     /**
      * Block and start the render loop.
      */
     void start_rendering();
 
+    /**
+     * Render a single frame, running frame tasks and callbacks as the render loop would. Lets headless runs step a
+     * fixed number of frames instead of blocking in start_rendering().
+     *
+     * @returns
+     *   True if rendering should continue, false if the engine has been asked to stop.
+     */
+    bool render_frame();
+
+    /**
+     * Copy the last rendered frame into memory.
+     *
+     * @returns
+     *   Pixels of the frame as tightly packed rows of 8 bit RGBA, top row first, frame_width() * frame_height() * 4
+     *   bytes in total.
+     */
+    std::vector<std::byte> capture_frame() const;
+
+    /**
+     * Get the width of the rendered frame.
+     *
+     * @returns
+     *   Width in pixels.
+     */
+    std::uint32_t frame_width() const;
+
+    /**
+     * Get the height of the rendered frame.
+     *
+     * @returns
+     *   Height in pixels.
+     */
+    std::uint32_t frame_height() const;
+
   private:
+    /**
+     * Called by OgreBites to pick a render system, picks the software render system when headless.
+     *
+     * @returns
+     *   True if a render system was picked, false if the app should not start.
+     */
+    bool oneTimeConfig() override;
+
+    /**
+     * Called by OgreBites to create the render window. When headless the window is created directly by the render
+     * system rather than through SDL, so no display is needed.
+     *
+     * @param name
+     *   Name of the window.
+     *
+     * @param width
+     *   Requested width in pixels, zero for the configured size.
+     *
+     * @param height
+     *   Requested height in pixels, zero for the configured size.
+     *
+     * @param misc_params
+     *   Extra parameters for the render system.
+     *
+     * @returns
+     *   The created window.
+     */
+    ::OgreBites::NativeWindowPair createWindow(
+        const ::Ogre::String &name,
+        std::uint32_t width,
+        std::uint32_t height,
+        ::Ogre::NameValuePairList misc_params) override;
+
     /**
      * Called by Ogre when the frame starts.
      *
@@ -235,14 +497,128 @@ class GraphicsManager : private ::OgreBites::ApplicationContext, ::OgreBites::In
      */
     bool keyPressed(const ::OgreBites::KeyboardEvent &evt) override;
 
+    /**
+     * Apply the shadow caster distance to an object which may cast shadows.
+     *
+     * @param object
+     *   The object to configure.
+     */
+    void configure_shadow_caster(::Ogre::MovableObject *object) const;
+
+    /**
+     * Load a mesh, generating levels of detail for it or loading them from the cache if any are configured.
+     *
+     * @param mesh_name
+     *   Name of mesh to load, must exist in a resource location.
+     *
+     * @returns
+     *   The loaded mesh.
+     */
+    ::Ogre::MeshPtr load_mesh(const std::string &mesh_name);
+
+    /**
+     * Create a plane (XZ) mesh with a unique name.
+     *
+     * @param width
+     *   The width of the mesh (x axis).
+     *
+     * @param height
+     *   The height of the mesh (z axis).
+     *
+     * @param x_segments
+     *   How many segments make up the plane in the x direction.
+     *
+     * @param z_segments
+     *   How many segments make up the plane in the z direction.
+     *
+     * @returns
+     *   Name of the new mesh.
+     */
+    std::string create_plane_mesh(float width, float height, std::uint32_t x_segments, std::uint32_t z_segments);
+
+    /**
+     * Get the static geometry for meshes which do or do not cast shadows, creating it on first use. Shadow casting
+     * is set for a whole StaticGeometry, so casters and non-casters are kept apart.
+     *
+     * @param casts_shadows
+     *   Whether to get the geometry for shadow casters.
+     *
+     * @returns
+     *   The static geometry.
+     */
+    ::Ogre::StaticGeometry *static_geometry(bool casts_shadows);
+
+    /**
+     * Get the instance manager for a mesh and technique, creating it on first use.
+     *
+     * @param mesh_name
+     *   Name of mesh to instance, must exist in a resource location.
+     *
+     * @param technique
+     *   The instancing technique to draw the mesh with.
+     *
+     * @returns
+     *   Instance manager for the mesh.
+     */
+    ::Ogre::InstanceManager *instance_manager(const std::string &mesh_name, InstancingTechnique technique);
+
+    /**
+     * Get a copy of a material with an instanced transform stage added to its generated shaders, so it can be drawn
+     * with HARDWARE_BASIC instancing. The copy is named "<material_name>/Instanced" and only created on first use, the
+     * original is left untouched for entities which are not instanced.
+     *
+     * @param material_name
+     *   The name of the material, must already exist.
+     *
+     * @returns
+     *   The name of the instanced copy.
+     */
+    std::string enable_instancing(const std::string &material_name);
+
+    /** Settings for rendering. */
+    GraphicsConfig config_;
+
     /** Ogre scene manager object. */
     ::Ogre::SceneManager *scene_manager_;
 
-    /** Collection of callbacks to fire on frame start. */
-    std::vector<std::function<void()>> frame_start_callbacks_;
+    /** Threads to run frame tasks on. */
+    JobSystem job_system_;
+
+    /** Tasks to run on frame start. */
+    TaskGraph frame_tasks_;
+
+    /** Number of callbacks registered with register_frame_start_callback(), used to chain them in order. */
+    std::uint32_t frame_start_callback_count_;
+
+    /** Current shadow settings. */
+    ShadowConfig shadow_config_;
+
+    /** Shader stage sampling the split shadow maps, only in the shader generator's render state for TEXTURE_PSSM. */
+    ::Ogre::RTShader::SubRenderState *pssm_state_;
+
+    /** Level of detail settings for added meshes. */
+    MeshLodSettings mesh_lod_;
+
+    /** Hash of mesh_lod_, identifying meshes generated with the current settings. */
+    std::uint64_t mesh_lod_hash_;
+
+    /** Generator for mesh levels of detail, created the first time levels are configured. */
+    std::unique_ptr<::Ogre::MeshLodGenerator> lod_generator_;
+
+    /** Static geometry for meshes which cast shadows, nullptr until first used. */
+    ::Ogre::StaticGeometry *static_casters_;
+
+    /** Static geometry for meshes which do not cast shadows, nullptr until first used. */
+    ::Ogre::StaticGeometry *static_receivers_;
+
+    /** Instance managers, keyed by the mesh they draw and their technique. */
+    std::map<std::pair<std::string, InstancingTechnique>, ::Ogre::InstanceManager *> instance_managers_;
+
+    /** Materials which have an instanced copy for HARDWARE_BASIC instancing. */
+    std::unordered_set<std::string> instanced_materials_;
 
     /** Collection of callbacks to fire on frame end. */
-    std::vector<std::function<void()>> frame_end_callbacks_;
+    std::vector<std::function<void(float)>> frame_end_callbacks_;
 };
 
 }
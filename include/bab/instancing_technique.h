@@ -0,0 +1,18 @@
+#pragma once
+
+namespace bab
+{
+
+/**
+ * Hardware instancing technique used to draw many copies of a mesh in a single batch.
+ */
+enum class InstancingTechnique
+{
+    /** Instance transforms are streamed in a per-instance vertex buffer, needs an instancing vertex shader. */
+    HARDWARE_BASIC,
+
+    /** Instance transforms are stored in a vertex texture, needs a vertex shader which samples it. */
+    HARDWARE_VTF
+};
+
+}
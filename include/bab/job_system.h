@@ -0,0 +1,127 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <stop_token>
+#include <thread>
+#include <vector>
+
+namespace bab
+{
+
+/**
+ * Pool of worker threads which run independent jobs. Every worker has its own queue, jobs submitted from a worker go
+ * on that worker's queue and idle workers steal the oldest jobs from the others, so a burst of work spreads itself
+ * across the pool without a single contended queue. Threads outside the pool share one extra queue.
+ */
+class JobSystem
+{
+  public:
+    /**
+     * Construct a new JobSystem.
+     *
+     * @param thread_count
+     *   Total number of threads to run jobs on, including the thread which waits on them, so a system of N threads
+     *   spawns N - 1 workers.
+     */
+    JobSystem(std::uint32_t thread_count);
+
+    /**
+     * Stops and joins all worker threads, any jobs still queued are dropped.
+     */
+    ~JobSystem();
+
+    // workers hold a pointer to the system so it cannot be copied or moved
+    JobSystem(const JobSystem &) = delete;
+    JobSystem &operator=(const JobSystem &) = delete;
+
+    /**
+     * Get the total number of threads jobs are run on, including the waiting thread.
+     *
+     * @returns
+     *   Number of threads.
+     */
+    std::uint32_t thread_count() const;
+
+    /**
+     * Queue a job to be run on any thread.
+     *
+     * @param job
+     *   The job to run.
+     */
+    void submit(std::function<void()> job);
+
+    /**
+     * Run a single queued job on the calling thread, used by threads waiting on jobs so they help rather than idle.
+     *
+     * @returns
+     *   True if a job was run, false if there were none queued.
+     */
+    bool run_one();
+
+  private:
+    /**
+     * Jobs owned by a single thread.
+     */
+    struct Queue
+    {
+        /** Guards jobs. */
+        std::mutex mutex;
+
+        /** Queued jobs, the owner works from the back and thieves from the front. */
+        std::deque<std::function<void()>> jobs;
+    };
+
+    /**
+     * Main loop for worker threads, runs jobs until stopped and sleeps when there are none.
+     *
+     * @param stop_token
+     *   Token signalled when the system is destroyed.
+     *
+     * @param queue_index
+     *   Index of the worker's own queue.
+     */
+    void worker_loop(std::stop_token stop_token, std::uint32_t queue_index);
+
+    /**
+     * Take a job, preferring the newest job in a thread's own queue and otherwise stealing the oldest job from another.
+     *
+     * @param queue_index
+     *   Index of the calling thread's queue.
+     *
+     * @returns
+     *   The job, or an empty optional if every queue is empty.
+     */
+    std::optional<std::function<void()>> take(std::uint32_t queue_index);
+
+    /**
+     * Get the index of the queue owned by the calling thread.
+     *
+     * @returns
+     *   Queue index, the shared queue for threads outside the pool.
+     */
+    std::uint32_t queue_index() const;
+
+    /** One queue per worker, plus the shared queue at index 0. */
+    std::vector<std::unique_ptr<Queue>> queues_;
+
+    /** Total number of queued jobs across all queues. */
+    std::atomic<std::uint32_t> queued_;
+
+    /** Guards sleeping, queued_ is only incremented while holding it so wakeups cannot be missed. */
+    std::mutex sleep_mutex_;
+
+    /** Signalled when a job is queued. */
+    std::condition_variable_any work_available_;
+
+    /** Worker threads, declared last so they are joined before the queues are destroyed. */
+    std::vector<std::jthread> workers_;
+};
+
+}
@@ -0,0 +1,44 @@
+#pragma once
+
+#include <vector>
+
+namespace bab
+{
+
+/**
+ * How the distance at which a mesh switches level of detail is measured.
+ */
+enum class MeshLodStrategy
+{
+    /** Switch by distance from the camera to the mesh bounds, in world units. */
+    DISTANCE,
+
+    /** Switch by the number of pixels the mesh covers on screen. */
+    PIXEL_COUNT
+};
+
+/**
+ * A generated level of detail for a mesh.
+ */
+struct MeshLodLevel
+{
+    /** Where the level starts, a distance that increases or a pixel count that decreases with each level. */
+    float value;
+
+    /** Proportion of vertices to remove from the full detail mesh, between 0 and 1. */
+    float reduction;
+};
+
+/**
+ * Settings for generating levels of detail for meshes added to the GraphicsManager.
+ */
+struct MeshLodSettings
+{
+    /** How level values are measured. */
+    MeshLodStrategy strategy = MeshLodStrategy::DISTANCE;
+
+    /** Levels to generate, ordered from most to least detailed. No levels means meshes are drawn at full detail. */
+    std::vector<MeshLodLevel> levels = {};
+};
+
+}
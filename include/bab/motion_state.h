@@ -0,0 +1,141 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+#include "LinearMath/btMotionState.h"
+#include "LinearMath/btQuaternion.h"
+#include "LinearMath/btTransform.h"
+#include "LinearMath/btVector3.h"
+
+namespace bab
+{
+
+/**
+ * Bullet motion state which keeps the last two simulated transforms of a rigid body, so the renderer can interpolate
+ * between fixed physics ticks. Bullet only updates active bodies, so the first update after the body was last synced
+ * adds its index to a shared dirty list, letting the renderer skip every body that has not moved.
+ */
+ATTRIBUTE_ALIGNED16(class) MotionState : public ::btMotionState
+{
+  public:
+    BT_DECLARE_ALIGNED_ALLOCATOR();
+
+    /**
+     * Construct a new MotionState.
+     *
+     * @param start_transform
+     *   The initial world transform of the rigid body.
+     *
+     * @param tick
+     *   Reference to the physics tick counter, used to detect bodies bullet has stopped updating.
+     *
+     * @param index
+     *   Index of the rigid body, added to the dirty list.
+     *
+     * @param dirty_list
+     *   List to add the index to when bullet updates the transform.
+     */
+    MotionState(
+        const ::btTransform &start_transform,
+        const std::uint64_t &tick,
+        std::uint32_t index,
+        std::vector<std::uint32_t> &dirty_list);
+
+    /**
+     * Get the world transform, bullet calls this when the rigid body is created.
+     *
+     * @param world_transform
+     *   Out parameter for the current world transform.
+     */
+    void getWorldTransform(::btTransform &world_transform) const override;
+
+    /**
+     * Set the world transform, bullet calls this after each step for every active rigid body.
+     *
+     * @param world_transform
+     *   The newly simulated world transform.
+     */
+    void setWorldTransform(const ::btTransform &world_transform) override;
+
+    /**
+     * Move the body without interpolating from its previous transform, used when the simulation state is restored.
+     *
+     * @param world_transform
+     *   The new world transform.
+     */
+    void reset(const ::btTransform &world_transform);
+
+    /**
+     * Get the world position interpolated between the last two ticks.
+     *
+     * @param alpha
+     *   How far between the previous (0.0) and current (1.0) tick to interpolate.
+     *
+     * @returns
+     *   Interpolated world position.
+     */
+    ::btVector3 interpolated_origin(float alpha) const;
+
+    /**
+     * Get the world orientation interpolated between the last two ticks.
+     *
+     * @param alpha
+     *   How far between the previous (0.0) and current (1.0) tick to interpolate.
+     *
+     * @returns
+     *   Interpolated world orientation.
+     */
+    ::btQuaternion interpolated_rotation(float alpha) const;
+
+    /**
+     * Get the tick the transform was last updated on.
+     *
+     * @returns
+     *   Tick of the last update.
+     */
+    std::uint64_t updated_tick() const;
+
+    /**
+     * Check if the index is in the dirty list.
+     *
+     * @returns
+     *   True if the body has been updated since it was last marked clean, otherwise false.
+     */
+    bool is_dirty() const;
+
+    /**
+     * Mark the body as clean, the caller is responsible for removing the index from the dirty list.
+     */
+    void mark_clean();
+
+  private:
+    /** Transform from the tick before the last update. */
+    ::btTransform previous_;
+
+    /** Transform from the last update. */
+    ::btTransform current_;
+
+    /** Rotation of previous_, kept so interpolating does not have to convert from a matrix every frame. */
+    ::btQuaternion previous_rotation_;
+
+    /** Rotation of current_. */
+    ::btQuaternion current_rotation_;
+
+    /** The physics tick counter. */
+    const std::uint64_t &tick_;
+
+    /** The tick the transform was last updated on. */
+    std::uint64_t updated_tick_;
+
+    /** Index of the rigid body. */
+    std::uint32_t index_;
+
+    /** List of updated bodies shared by all motion states. */
+    std::vector<std::uint32_t> &dirty_list_;
+
+    /** Whether index_ is in the dirty list. */
+    bool dirty_;
+};
+
+}
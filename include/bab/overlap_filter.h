@@ -0,0 +1,33 @@
+#pragma once
+
+#include "BulletCollision/BroadphaseCollision/btBroadphaseProxy.h"
+#include "BulletCollision/BroadphaseCollision/btOverlappingPairCache.h"
+
+namespace bab
+{
+
+/**
+ * Broadphase callback which decides if two overlapping objects should become a pair for the dispatcher. As well as
+ * honouring collision filters it rejects pairs where neither object can move, which bullet would otherwise keep in the
+ * pair cache only to skip in the narrowphase every tick. Ghost objects are only paired with rigid bodies that can move,
+ * as those are the only overlaps a trigger volume reports.
+ */
+class OverlapFilter : public ::btOverlapFilterCallback
+{
+  public:
+    /**
+     * Check if two proxies should be paired, bullet calls this whenever their bounds start overlapping.
+     *
+     * @param proxy0
+     *   First proxy.
+     *
+     * @param proxy1
+     *   Second proxy.
+     *
+     * @returns
+     *   True if the pair should be added to the pair cache, otherwise false.
+     */
+    bool needBroadphaseCollision(::btBroadphaseProxy *proxy0, ::btBroadphaseProxy *proxy1) const override;
+};
+
+}
@@ -0,0 +1,85 @@
+#pragma once
+
+#include <cstdint>
+
+#include "vector3.h"
+
+namespace bab
+{
+
+/**
+ * Algorithm used to find potentially colliding pairs of objects.
+ */
+enum class BroadphaseType
+{
+    /** Dynamic bounding volume tree, works for any scene size and handles lots of moving objects well. */
+    DBVT,
+
+    /**
+     * Sweep and prune with 16 bit quantised bounds, fast for mostly static scenes. Limited to 32766 objects, larger
+     * capacities use the 32 bit version instead.
+     */
+    AXIS_SWEEP,
+
+    /** Sweep and prune with 32 bit quantised bounds, for larger or more precise mostly static scenes. */
+    AXIS_SWEEP_32
+};
+
+/**
+ * Collision configuration used to pick the narrowphase algorithm for each pair of shapes.
+ */
+enum class CollisionConfigurationType
+{
+    /** Bullet's default algorithms. */
+    DEFAULT,
+
+    /** A box specialised algorithm for box plane pairs, bullet's defaults for everything else. */
+    BOX_PLANE
+};
+
+/**
+ * Settings used when constructing a PhysicsManager.
+ */
+struct PhysicsConfig
+{
+    /** Number of fixed simulation ticks to run per second of real time. */
+    float tick_rate = 60.0f;
+
+    /** Maximum number of ticks to run in a single update, any time beyond this is dropped. */
+    std::uint32_t max_substeps = 4u;
+
+    /**
+     * Number of threads to simulate on, anything above one uses bullet's multithreaded world. Worlds share one pool
+     * sized to the machine, so this is capped at its size.
+     */
+    std::uint32_t thread_count = 1u;
+
+    /** Whether to run the simulation on its own thread, publishing transforms as snapshots. */
+    bool asynchronous = false;
+
+    /** Broadphase algorithm to use. */
+    BroadphaseType broadphase = BroadphaseType::DBVT;
+
+    /** Minimum corner of the world, sweep and prune broadphases clamp anything outside the bounds. */
+    Vector3 world_min = {-1000.0f, -1000.0f, -1000.0f};
+
+    /** Maximum corner of the world. */
+    Vector3 world_max = {1000.0f, 1000.0f, 1000.0f};
+
+    /** Maximum number of collision objects a sweep and prune broadphase can hold, must be at least 2. */
+    std::uint32_t max_broadphase_objects = 16384u;
+
+    /** Collision configuration to use. */
+    CollisionConfigurationType collision_configuration = CollisionConfigurationType::DEFAULT;
+
+    /**
+     * Physics level of detail, rigid bodies further than this from every focus point are frozen until one comes back
+     * into range. Zero, or no focus points set, simulates everything.
+     */
+    float lod_simulation_distance = 0.0f;
+
+    /** Number of ticks between re-evaluating which rigid bodies are in range. */
+    std::uint32_t lod_update_interval = 15u;
+};
+
+}
@@ -1,24 +1,51 @@
 #pragma once
 
+#include <cstddef>
+#include <cstdint>
 #include <functional>
 #include <memory>
+#include <mutex>
+#include <optional>
+#include <span>
+#include <stop_token>
+#include <string>
+#include <thread>
 #include <unordered_map>
 #include <vector>
 
-#include "collision_callback.h"
+#include "box_rigid_body_desc.h"
+#include "collision_event.h"
+#include "collision_layers.h"
+#include "motion_state.h"
+#include "overlap_filter.h"
+#include "physics_config.h"
+#include "physics_query.h"
+#include "quaternion.h"
 #include "rigid_body.h"
+#include "rigid_body_pool.h"
+#include "shape_cache.h"
+#include "thread_pool.h"
+#include "transform_snapshot.h"
+#include "trigger_event.h"
+#include "trigger_volume.h"
+#include "triple_buffer.h"
 #include "vector3.h"
 
+#include "BulletCollision/BroadphaseCollision/btBroadphaseInterface.h"
 #include "BulletCollision/BroadphaseCollision/btDbvtBroadphase.h"
 #include "BulletCollision/CollisionDispatch/btCollisionDispatcher.h"
+#include "BulletCollision/CollisionDispatch/btCollisionDispatcherMt.h"
 #include "BulletCollision/CollisionDispatch/btDefaultCollisionConfiguration.h"
 #include "BulletCollision/CollisionDispatch/btGhostObject.h"
-#include "BulletCollision/CollisionShapes/btBoxShape.h"
+#include "BulletCollision/NarrowPhaseCollision/btPersistentManifold.h"
+#include "BulletDynamics/ConstraintSolver/btConstraintSolver.h"
 #include "BulletDynamics/ConstraintSolver/btSequentialImpulseConstraintSolver.h"
 #include "BulletDynamics/Dynamics/btDiscreteDynamicsWorld.h"
+#include "BulletDynamics/Dynamics/btDiscreteDynamicsWorldMt.h"
 #include "BulletDynamics/Dynamics/btRigidBody.h"
-#include "LinearMath/btDefaultMotionState.h"
 #include "LinearMath/btIDebugDraw.h"
+#include "LinearMath/btThreads.h"
+#include "LinearMath/btVector3.h"
 
 namespace bab
 {
@@ -27,14 +54,24 @@ class DebugDrawer;
 
 /**
  * Class to handle all things related to physics.
+ *
+ * When constructed with PhysicsConfig::asynchronous the simulation runs on its own thread and every function which
+ * changes the simulation synchronises with it. In this mode collision callbacks are fired from the physics thread and
+ * rendering should use latest_snapshot() rather than reading rigid bodies directly.
+ *
+ * Collision and trigger callbacks are fired after the ticks of an update have run and without holding any lock, so
+ * they are free to call back into the manager.
  */
 class PhysicsManager
 {
   public:
     /**
      * Construct a new PhysicsManager.
+     *
+     * @param config
+     *   Settings for the simulation, throws std::runtime_error if they are invalid.
      */
-    PhysicsManager();
+    PhysicsManager(const PhysicsConfig &config = {});
 
     /**
      * PhysicsManager specific cleanup.
@@ -49,8 +86,17 @@ class PhysicsManager
      *
      * @param position
      *   The position in world space of the rigid body.
+     *
+     * @param filter
+     *   Collision filter for the rigid body, defaults to the "static" layer.
+     *
+     * @returns
+     *   Handle to the new rigid body.
      */
-    void add_static_rigid_body(const Vector3 &half_extent, const Vector3 &position);
+    RigidBody add_static_rigid_body(
+        const Vector3 &half_extent,
+        const Vector3 &position,
+        const std::optional<CollisionFilter> &filter = std::nullopt);
 
     /**
      * Add a cube dynamic rigid body to the simulation.
@@ -64,10 +110,190 @@ class PhysicsManager
      * @param mass
      *   The mass of the rigid body.
      *
+     * @param filter
+     *   Collision filter for the rigid body, defaults to the "default" layer.
+     *
+     * @returns
+     *   Handle to the new rigid body.
+     */
+    RigidBody add_dynamic_rigid_body(
+        const Vector3 &half_extent,
+        const Vector3 &position,
+        float mass,
+        const std::optional<CollisionFilter> &filter = std::nullopt);
+
+    /**
+     * Add many cube dynamic rigid bodies to the simulation at once. Storage is reserved up front and, with the dbvt
+     * broadphase, the bodies are inserted without querying for pairs one at a time. The tree is then rebuilt and pairs
+     * found for the whole batch in one pass, which is far quicker than adding the bodies individually.
+     *
+     * @param descs
+     *   Descriptions of the rigid bodies to add.
+     *
+     * @param filter
+     *   Collision filter for every rigid body, defaults to the "default" layer.
+     *
+     * @returns
+     *   Handles to the new rigid bodies, in the same order as descs.
+     */
+    std::vector<RigidBody> add_dynamic_rigid_bodies(
+        std::span<const BoxRigidBodyDesc> descs,
+        const std::optional<CollisionFilter> &filter = std::nullopt);
+
+    /**
+     * Add a static rigid body with the triangles of an ogre mesh as its collision shape. The bvh used to collide with
+     * the triangles is cached in a file next to the mesh, so only the first run with a new or changed mesh builds it.
+     *
+     * @param mesh_name
+     *   Name of mesh to load, must exist in a resource location.
+     *
+     * @param position
+     *   The position in world space of the rigid body.
+     *
+     * @param orientation
+     *   The orientation in world space of the rigid body.
+     *
+     * @param scale
+     *   Scale to apply to the mesh.
+     *
+     * @param filter
+     *   Collision filter for the rigid body, defaults to the "static" layer.
+     *
      * @returns
-     *   Wrapper for the internal bullet rigid body.
+     *   Handle to the new rigid body.
      */
-    RigidBody add_dynamic_rigid_body(const Vector3 &half_extent, const Vector3 &position, float mass);
+    RigidBody add_static_mesh_rigid_body(
+        const std::string &mesh_name,
+        const Vector3 &position,
+        const Quaternion &orientation,
+        const Vector3 &scale = Vector3::UNIT_SCALE,
+        const std::optional<CollisionFilter> &filter = std::nullopt);
+
+    /**
+     * Add an infinite static plane to the simulation, typically used as the ground.
+     *
+     * @param normal
+     *   Unit normal of the plane, the side it points to is outside.
+     *
+     * @param distance
+     *   Distance of the plane from the origin along the normal.
+     *
+     * @param filter
+     *   Collision filter for the rigid body, defaults to the "static" layer.
+     *
+     * @returns
+     *   Handle to the new rigid body.
+     */
+    RigidBody add_static_plane_rigid_body(
+        const Vector3 &normal,
+        float distance,
+        const std::optional<CollisionFilter> &filter = std::nullopt);
+
+    /**
+     * Remove a rigid body from the simulation and free its storage for reuse. Any registered collision callback for
+     * the body is dropped. Removing an already removed rigid body does nothing. When called from a collision or
+     * trigger callback the removal happens once every callback for the update has run, so other callbacks can still use
+     * the handle.
+     *
+     * @param rigid_body
+     *   The rigid body to remove.
+     */
+    void remove_rigid_body(const RigidBody &rigid_body);
+
+    /**
+     * Take a rigid body out of the simulation without destroying it, so it can be cheaply brought back with
+     * enable_rigid_body(). Contacts and any registered collision callback are dropped. Disabling a disabled rigid body
+     * does nothing.
+     *
+     * @param rigid_body
+     *   The rigid body to disable.
+     */
+    void disable_rigid_body(const RigidBody &rigid_body);
+
+    /**
+     * Put a disabled rigid body back into the simulation at rest, with the collision filter it had when disabled.
+     *
+     * @param rigid_body
+     *   The rigid body to enable, must be disabled.
+     *
+     * @param position
+     *   The new position in world space of the rigid body.
+     *
+     * @param orientation
+     *   The new orientation in world space of the rigid body.
+     */
+    void enable_rigid_body(const RigidBody &rigid_body, const Vector3 &position, const Quaternion &orientation);
+
+    /**
+     * Add a box trigger volume to the simulation. Trigger volumes have no collision response and only use broadphase
+     * bounds overlap to report rigid bodies entering and leaving, so they are cheap enough to have thousands of. Static
+     * rigid bodies never trigger them.
+     *
+     * @param half_extent
+     *   The half extents of the box.
+     *
+     * @param position
+     *   The position in world space of the trigger volume.
+     *
+     * @param filter
+     *   Collision filter for the trigger volume, defaults to the "sensor" layer.
+     *
+     * @returns
+     *   Handle to the new trigger volume.
+     */
+    TriggerVolume add_trigger_volume(
+        const Vector3 &half_extent,
+        const Vector3 &position,
+        const std::optional<CollisionFilter> &filter = std::nullopt);
+
+    /**
+     * Remove a trigger volume from the simulation, no exit events are fired for rigid bodies inside it. Removing an
+     * already removed trigger volume does nothing.
+     *
+     * @param trigger
+     *   The trigger volume to remove.
+     */
+    void remove_trigger_volume(const TriggerVolume &trigger);
+
+    /**
+     * Set the points rigid body distances are measured from for physics level of detail, typically cameras and
+     * players. Bodies are frozen or woken every PhysicsConfig::lod_update_interval ticks.
+     *
+     * @param focus_points
+     *   World positions to measure from, empty simulates everything.
+     */
+    void set_lod_focus_points(std::span<const Vector3> focus_points);
+
+    /**
+     * Get the table of named collision layers, used to build filters for rigid bodies.
+     *
+     * @returns
+     *   Collision layer table.
+     */
+    CollisionLayers &collision_layers();
+
+    /**
+     * Change which layers a rigid body is in and collides with. Existing contacts that the new filter rejects end on
+     * the next tick. A disabled rigid body keeps the filter until it is enabled.
+     *
+     * @param rigid_body
+     *   The rigid body to change.
+     *
+     * @param filter
+     *   The new collision filter.
+     */
+    void set_collision_filter(const RigidBody &rigid_body, const CollisionFilter &filter);
+
+    /**
+     * Get the collision filter of a rigid body.
+     *
+     * @param rigid_body
+     *   The rigid body to get the filter of.
+     *
+     * @returns
+     *   Collision filter of the rigid body.
+     */
+    CollisionFilter collision_filter(const RigidBody &rigid_body);
 
     /**
      * Register a new collision callback.
@@ -76,11 +302,30 @@ class PhysicsManager
      *   The rigid body to test for collisions to fire the callback.
      *
      * @param callback
-     *   The callback to fire when the rigid body has a collision, the callback should return true if it is to be
-     *   consumed and not fired again, or false if it should be fired on further collisions.
+     *   The callback to fire once per dispatch if the rigid body was touching anything since the last dispatch, the
+     *   callback should return true if it is to be consumed and not fired again, or false if it should be fired on
+     *   further collisions.
      */
     void register_collision_callback(const RigidBody &rigid_body, std::function<bool()> callback);
 
+    /**
+     * Register a callback to receive all collision events. After every tick the callback is fired once with every
+     * contact that began, persisted or ended during that tick.
+     *
+     * @param callback
+     *   The callback to fire with the events of a tick, the span is only valid for the duration of the call.
+     */
+    void register_collision_event_callback(std::function<void(std::span<const CollisionEvent>)> callback);
+
+    /**
+     * Register a callback to receive all trigger events. After every tick the callback is fired once with every rigid
+     * body that entered or left a trigger volume during that tick.
+     *
+     * @param callback
+     *   The callback to fire with the events of a tick, the span is only valid for the duration of the call.
+     */
+    void register_trigger_event_callback(std::function<void(std::span<const TriggerEvent>)> callback);
+
     /**
      * Set the DebugDraer object, until this is called no debug information will be rendered.
      *
@@ -90,43 +335,513 @@ class PhysicsManager
     void set_debug_drawer(DebugDrawer *debug_drawer);
 
     /**
-     * Advance the physics simulation, should be called every frame.
+     * Advance the physics simulation, should be called every frame. The simulation is run in fixed ticks, so this may
+     * run zero or more ticks depending on how much time has accumulated. When running asynchronously this only draws
+     * the debug information recorded with the latest snapshot, as the physics thread advances the simulation.
+     *
+     * @param delta
+     *   Time in seconds since the last update.
+     */
+    void update(float delta);
+
+    /**
+     * Find the closest rigid body hit by each of a batch of rays. Objects without contact response are ignored. The
+     * batch is split across the thread pool when the simulation is multithreaded.
+     *
+     * @param rays
+     *   The rays to test.
+     *
+     * @param hits
+     *   Where to write the result for each ray, must be the same size as rays.
+     */
+    void raycast_batch(std::span<const Ray> rays, std::span<Hit> hits);
+
+    /**
+     * Find the closest rigid body hit by each of a batch of boxes swept through the world. Objects without contact
+     * response are ignored. The batch is split across the thread pool when the simulation is multithreaded.
+     *
+     * @param sweeps
+     *   The sweeps to test.
+     *
+     * @param hits
+     *   Where to write the result for each sweep, must be the same size as sweeps.
+     */
+    void sweep_batch(std::span<const BoxSweep> sweeps, std::span<Hit> hits);
+
+    /**
+     * Get the size of buffer snapshot() needs to store the current state of the simulation.
+     *
+     * @returns
+     *   Size in bytes.
+     */
+    std::size_t snapshot_size();
+
+    /**
+     * Write the state of every moving rigid body (transform, velocity and activation) along with the contact points the
+     * solver warm starts from into a buffer. Static rigid bodies are not stored as they never change.
+     *
+     * @param buffer
+     *   Buffer to write to, should be at least snapshot_size() bytes.
+     *
+     * @returns
+     *   Number of bytes written, or zero if the buffer is too small, which can happen if the world grew since
+     *   snapshot_size() was called. Nothing is written on failure.
+     */
+    std::size_t snapshot(std::span<std::byte> buffer);
+
+    /**
+     * Put the simulation back into the state stored by snapshot(). Rigid bodies removed since the snapshot are skipped
+     * and rigid bodies added since keep their current state. Contacts are only restored for pairs the broadphase is
+     * still tracking, any others are rebuilt by the next tick.
+     *
+     * @param buffer
+     *   Buffer previously written by snapshot().
+     *
+     * @returns
+     *   True if the snapshot was restored, false if the buffer is truncated or corrupt, in which case the simulation is
+     *   left unchanged.
      */
-    void update();
+    bool restore(std::span<const std::byte> buffer);
+
+    /**
+     * Check if the simulation is running on its own thread.
+     *
+     * @returns
+     *   True if running asynchronously, otherwise false.
+     */
+    bool is_asynchronous() const;
+
+    /**
+     * Get the most recent transform snapshot published by the physics thread, never blocks. Only valid when running
+     * asynchronously and must only be called from a single thread.
+     *
+     * @returns
+     *   Latest snapshot, valid until the next call.
+     */
+    const TransformSnapshot &latest_snapshot();
+
+    /**
+     * Get the rigid bodies whose rendered transform needs syncing this frame, should be called once per frame. This is
+     * every rigid body bullet updated in the latest tick, plus those it has stopped updating since the last call. Not
+     * available when running asynchronously.
+     *
+     * @returns
+     *   Indices of the moved rigid bodies, valid until the next call.
+     */
+    std::span<const std::uint32_t> moved_rigid_bodies();
+
+    /**
+     * Get how far between the last two ticks the simulation time currently is, for interpolating rendered transforms.
+     *
+     * @returns
+     *   Value in the range [0.0, 1.0] where 0.0 is the previous tick and 1.0 the latest tick.
+     */
+    float interpolation_alpha() const;
 
   private:
-    /** Default configuration for collision detection. */
-    ::btDefaultCollisionConfiguration collision_config_;
+    /**
+     * Contact between two collision objects found during a tick.
+     */
+    struct ContactPair
+    {
+        /** The collision object with the lower address. */
+        const ::btCollisionObject *object_a;
+
+        /** The collision object with the higher address. */
+        const ::btCollisionObject *object_b;
+
+        /** World position of the deepest contact point. */
+        ::btVector3 point;
+
+        /** Total impulse applied across all contact points. */
+        ::btScalar impulse;
+    };
+
+    /**
+     * A per body collision callback, taken out of the map while it runs.
+     */
+    struct FiredCallback
+    {
+        /** The rigid body the callback is registered for. */
+        const ::btRigidBody *body;
+
+        /** The callback. */
+        std::function<bool()> function;
+
+        /** Whether the callback returned true. */
+        bool consumed;
+    };
+
+    /**
+     * Storage slot for a trigger volume.
+     */
+    struct Trigger
+    {
+        /** Ghost object tracking what overlaps the trigger volume, null if the slot is free. */
+        std::unique_ptr<::btGhostObject> ghost;
+
+        /** Incremented every time the slot is freed, so stale handles can be detected. */
+        std::uint32_t generation;
+
+        /** Rigid bodies overlapping the trigger volume at the end of the last tick, as sorted overlap keys. */
+        std::vector<std::uint64_t> overlaps;
+    };
+
+    /**
+     * Run as many ticks as the accumulated time allows, the caller must hold the world mutex.
+     *
+     * @param delta
+     *   Time in seconds since the last call.
+     *
+     * @returns
+     *   Number of ticks run.
+     */
+    std::uint32_t simulate(float delta);
+
+    /**
+     * Main loop of the physics thread when running asynchronously.
+     *
+     * @param stop_token
+     *   Token signalled when the manager is destroyed.
+     */
+    void run_asynchronous(std::stop_token stop_token);
+
+    /**
+     * Copy the transform of every rigid body into the snapshot buffer and publish it, the caller must hold the world
+     * mutex.
+     */
+    void publish_snapshot();
+
+    /**
+     * Check if a rigid body is close enough to a focus point to be simulated.
+     *
+     * @param rigid_body
+     *   The rigid body.
+     *
+     * @returns
+     *   True if the body should be simulated, always true if level of detail is off.
+     */
+    bool is_in_lod_range(const ::btRigidBody &rigid_body) const;
+
+    /**
+     * Freeze every moving rigid body out of range and wake any frozen body back in range. A simulation island is only
+     * frozen if all of its bodies are out of range, so an island never runs in part. The state is derived from each
+     * body's activation state, so it also corrects bodies restored from a snapshot.
+     */
+    void update_lod();
+
+    /**
+     * Create a cube dynamic rigid body and add it to the world, the caller must hold the world mutex.
+     *
+     * @param half_extent
+     *   The half extends of the cube representing the rigid body.
+     *
+     * @param position
+     *   The position in world space of the rigid body.
+     *
+     * @param mass
+     *   The mass of the rigid body.
+     *
+     * @param filter
+     *   Collision filter for the rigid body.
+     *
+     * @returns
+     *   Handle to the new rigid body.
+     */
+    RigidBody create_dynamic_box(
+        const Vector3 &half_extent,
+        const Vector3 &position,
+        float mass,
+        const CollisionFilter &filter);
+
+    /**
+     * Remove a rigid body from the world and free its slot, the caller must hold the world mutex.
+     *
+     * @param index
+     *   Index of a live rigid body.
+     */
+    void destroy_rigid_body(std::uint32_t index);
+
+    /**
+     * Remove the rigid bodies whose removal was requested while dispatching events, the caller must hold the world
+     * mutex.
+     */
+    void flush_pending_removals();
+
+    /**
+     * Drop everything the manager tracks about a rigid body that is leaving the world, the caller must hold the world
+     * mutex.
+     *
+     * @param index
+     *   Index of the rigid body.
+     */
+    void forget_rigid_body(std::uint32_t index);
+
+    /**
+     * Add a rigid body from the pool to the dynamics world.
+     *
+     * @param rigid_body
+     *   The rigid body to add.
+     *
+     * @param filter
+     *   Collision filter for the rigid body.
+     */
+    void add_to_world(::btRigidBody &rigid_body, const CollisionFilter &filter);
+
+    /**
+     * Get the size of buffer snapshot() needs, filling snapshot_manifolds_ along the way. The caller must hold the
+     * world mutex.
+     *
+     * @returns
+     *   Size in bytes.
+     */
+    std::size_t measure_snapshot();
+
+    /**
+     * Fill snapshot_manifolds_ with the manifolds between rigid bodies that have contacts, sorted by rigid body index.
+     *
+     * @returns
+     *   Total number of contact points in the collected manifolds.
+     */
+    std::uint32_t collect_snapshot_manifolds();
+
+    /**
+     * Fill current_contact_pairs_ with the touching pairs in the dispatcher's manifolds, sorted with one entry per
+     * pair. The caller must hold the world mutex.
+     */
+    void gather_contact_pairs();
+
+    /**
+     * Walk the persistent manifolds left by the last tick, compare them to the previous tick and queue collision
+     * events, the caller must hold the world mutex.
+     */
+    void collect_collision_events();
+
+    /**
+     * Fill current_overlaps_ with the sorted keys of the rigid bodies a trigger volume overlaps. The caller must hold
+     * the world mutex.
+     *
+     * @param trigger
+     *   The trigger volume, must have a ghost.
+     */
+    void gather_trigger_overlaps(const Trigger &trigger);
+
+    /**
+     * Compare the overlaps of each trigger volume to the previous tick and queue trigger events, the caller must hold
+     * the world mutex.
+     */
+    void collect_trigger_events();
+
+    /**
+     * Fire every callback for the queued events, the caller must not hold the world mutex.
+     */
+    void dispatch_events();
+
+    /**
+     * Run a batch of queries, on the thread pool if there is one, the caller must hold the world mutex.
+     *
+     * @param count
+     *   Number of queries in the batch.
+     *
+     * @param body
+     *   Function to call with each range [begin, end) of queries to run.
+     */
+    void run_queries(std::int32_t count, const std::function<void(std::int32_t, std::int32_t)> &body);
+
+    /**
+     * Find the closest rigid body hit by a ray, walking the broadphase trees directly.
+     *
+     * @param ray
+     *   The ray to test.
+     *
+     * @returns
+     *   The closest hit, if any.
+     */
+    Hit raycast(const Ray &ray);
+
+    /**
+     * Find the closest rigid body hit by a swept box, walking the broadphase trees directly.
+     *
+     * @param sweep
+     *   The sweep to test.
+     *
+     * @returns
+     *   The closest hit, if any.
+     */
+    Hit sweep(const BoxSweep &sweep);
+
+    /**
+     * Get a handle for a bullet collision object created by the pool.
+     *
+     * @param object
+     *   The bullet collision object, must be a rigid body from the pool.
+     *
+     * @returns
+     *   Handle to the rigid body.
+     */
+    RigidBody to_handle(const ::btCollisionObject *object);
+
+    /** Pool shared by every multithreaded world, null when single threaded. */
+    ThreadPool *thread_pool_;
+
+    /** Maximum number of threads this world's loops run on. */
+    std::uint32_t thread_count_;
+
+    /** Configuration for collision detection, chosen by the config. */
+    std::unique_ptr<::btDefaultCollisionConfiguration> collision_config_;
 
     /** Calculations for handling collision pairs. */
-    ::btCollisionDispatcher collision_dispatcher_;
+    std::unique_ptr<::btCollisionDispatcher> collision_dispatcher_;
 
-    /** Broadphase implementation. */
-    ::btDbvtBroadphase broadphase_;
+    /** Broadphase implementation, chosen by the config. */
+    std::unique_ptr<::btBroadphaseInterface> broadphase_;
 
-    /** Constrain solver. */
-    ::btSequentialImpulseConstraintSolver solver_;
+    /** The broadphase if it is a dbvt, which queries can walk directly, otherwise null. */
+    ::btDbvtBroadphase *dbvt_broadphase_;
+
+    /** Constrain solver, a pool of solvers when multithreaded. */
+    std::unique_ptr<::btConstraintSolver> solver_;
 
     /** Callback for handling ghost collision pairs. */
     ::btGhostPairCallback ghost_pair_callback_;
 
+    /** Broadphase filter deciding which overlapping objects become pairs. */
+    OverlapFilter overlap_filter_;
+
     /** Simulated physics world. */
-    ::btDiscreteDynamicsWorld world_;
+    std::unique_ptr<::btDiscreteDynamicsWorld> world_;
 
-    /** Collection of collision states. */
-    std::vector<std::unique_ptr<::btBoxShape>> shapes_;
+    /** Shared collision shapes. */
+    ShapeCache shape_cache_;
 
-    /** Collection of motion states. */
-    std::vector<std::unique_ptr<::btDefaultMotionState>> motion_states_;
+    /** Named collision layers for building filters. */
+    CollisionLayers collision_layers_;
 
-    /** Collection of created rigid bodies. */
-    std::vector<std::unique_ptr<::btRigidBody>> rigid_bodies_;
+    /** Storage for created rigid bodies and their motion states. */
+    RigidBodyPool rigid_bodies_;
 
     /** Optional object for handling debug information. */
     DebugDrawer *debug_drawer_;
 
+    /** Debug lines recorded for the next snapshot. */
+    std::vector<Vector3> debug_lines_;
+
+    /** Records debug lines into debug_lines_ on the physics thread, when running asynchronously. */
+    std::unique_ptr<::btIDebugDraw> debug_recorder_;
+
     /** Map of rigid bodies to their registered collision callbacks. */
-    std::unordered_map<::btRigidBody *, std::function<bool()>> collision_callbacks_;
+    std::unordered_map<const ::btRigidBody *, std::function<bool()>> collision_callbacks_;
+
+    /** Collection of callbacks to fire with each tick's collision events. */
+    std::vector<std::function<void(std::span<const CollisionEvent>)>> collision_event_callbacks_;
+
+    /** Contacts from the previous tick, sorted by object addresses. */
+    std::vector<ContactPair> contact_pairs_;
+
+    /** Rigid bodies which left the world since the last tick, whose contacts are still in contact_pairs_. */
+    std::vector<const ::btCollisionObject *> forgotten_bodies_;
+
+    /** Scratch storage for the contacts of the current tick, kept to avoid reallocating every tick. */
+    std::vector<ContactPair> current_contact_pairs_;
+
+    /** Collision events queued since they were last dispatched. */
+    std::vector<CollisionEvent> collision_events_;
+
+    /** End of each tick's events in collision_events_, for ticks which had any. */
+    std::vector<std::size_t> collision_tick_ends_;
+
+    /** Rigid bodies with a callback that were touching something since the last dispatch, may repeat. */
+    std::vector<const ::btRigidBody *> callback_bodies_;
+
+    /** Collision events being dispatched, so callbacks can run without the lock while new events are queued. */
+    std::vector<CollisionEvent> fired_collision_events_;
+
+    /** End of each tick's events in fired_collision_events_. */
+    std::vector<std::size_t> fired_collision_tick_ends_;
+
+    /** Per body callbacks being dispatched. */
+    std::vector<FiredCallback> fired_callbacks_;
+
+    /** Copy of the collision event callbacks being dispatched, so callbacks can register more while they run. */
+    std::vector<std::function<void(std::span<const CollisionEvent>)>> fired_collision_event_callbacks_;
+
+    /** Thread running callbacks, or no thread if none are running. */
+    std::thread::id dispatch_thread_;
+
+    /** Rigid bodies removed by callbacks while dispatching, removed once every callback has run. */
+    std::vector<RigidBody> pending_removals_;
+
+    /** Collision filter of each disabled rigid body, indexed by rigid body index. */
+    std::vector<CollisionFilter> disabled_filters_;
+
+    /** Storage for created trigger volumes, indexed by trigger volume index. */
+    std::vector<Trigger> triggers_;
+
+    /** Indices of free slots in triggers_. */
+    std::vector<std::uint32_t> free_triggers_;
+
+    /** Collection of callbacks to fire with each tick's trigger events. */
+    std::vector<std::function<void(std::span<const TriggerEvent>)>> trigger_event_callbacks_;
+
+    /** Scratch storage for the overlaps of a trigger volume this tick. */
+    std::vector<std::uint64_t> current_overlaps_;
+
+    /** Trigger events queued since they were last dispatched. */
+    std::vector<TriggerEvent> trigger_events_;
+
+    /** End of each tick's events in trigger_events_, for ticks which had any. */
+    std::vector<std::size_t> trigger_tick_ends_;
+
+    /** Trigger events being dispatched. */
+    std::vector<TriggerEvent> fired_trigger_events_;
+
+    /** End of each tick's events in fired_trigger_events_. */
+    std::vector<std::size_t> fired_trigger_tick_ends_;
+
+    /** Copy of the trigger event callbacks being dispatched. */
+    std::vector<std::function<void(std::span<const TriggerEvent>)>> fired_trigger_event_callbacks_;
+
+    /** Length of a single simulation tick in seconds. */
+    float fixed_time_step_;
+
+    /** Maximum number of ticks to run in a single update. */
+    std::uint32_t max_substeps_;
+
+    /** Time in seconds that has been accumulated but not yet simulated. */
+    float accumulator_;
+
+    /** Number of ticks simulated so far. */
+    std::uint64_t tick_;
+
+    /** Indices of rigid bodies updated since they were last reported as moved, filled in by their motion states. */
+    std::vector<std::uint32_t> dirty_bodies_;
+
+    /** Scratch storage for the result of moved_rigid_bodies(). */
+    std::vector<std::uint32_t> moved_bodies_;
+
+    /** Distance from a focus point beyond which rigid bodies are frozen, zero for no level of detail. */
+    float lod_simulation_distance_;
+
+    /** Number of ticks between re-evaluating which rigid bodies are in range. */
+    std::uint32_t lod_update_interval_;
+
+    /** Points distances are measured from for level of detail. */
+    std::vector<Vector3> lod_focus_points_;
+
+    /** Scratch storage for whether each simulation island has a body in range, indexed by island tag. */
+    std::vector<bool> lod_islands_in_range_;
+
+    /** Scratch storage for the manifolds written by snapshot(). */
+    std::vector<const ::btPersistentManifold *> snapshot_manifolds_;
+
+    /** Guards the simulation when running asynchronously. */
+    std::mutex world_mutex_;
+
+    /** Snapshots handed from the physics thread to the renderer. */
+    TripleBuffer<TransformSnapshot> snapshots_;
+
+    /** Thread running the simulation, only started when running asynchronously. */
+    std::jthread physics_thread_;
 };
 
 }
\ No newline at end of file
@@ -0,0 +1,56 @@
+#pragma once
+
+#include <optional>
+
+#include "rigid_body.h"
+#include "vector3.h"
+
+namespace bab
+{
+
+/**
+ * A line segment to test against the physics world.
+ */
+struct Ray
+{
+    /** World position the ray starts at. */
+    Vector3 from;
+
+    /** World position the ray ends at. */
+    Vector3 to;
+};
+
+/**
+ * An axis aligned box moved along a line segment to test against the physics world.
+ */
+struct BoxSweep
+{
+    /** Half extents of the box. */
+    Vector3 half_extent;
+
+    /** World position the centre of the box starts at. */
+    Vector3 from;
+
+    /** World position the centre of the box ends at. */
+    Vector3 to;
+};
+
+/**
+ * Result of a single ray or sweep query, describes the closest rigid body along the query.
+ */
+struct Hit
+{
+    /** The rigid body that was hit, empty if the query did not hit anything. */
+    std::optional<RigidBody> body;
+
+    /** World position of the hit, zero if nothing was hit. */
+    Vector3 point = Vector3::ZERO;
+
+    /** World space surface normal at the hit, zero if nothing was hit. */
+    Vector3 normal = Vector3::ZERO;
+
+    /** How far along the query the hit is, from 0.0 at the start to 1.0 at the end. */
+    float fraction = 1.0f;
+};
+
+}
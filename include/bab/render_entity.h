@@ -1,10 +1,13 @@
 #pragma once
 
+#include <string>
+
 #include "quaternion.h"
 #include "vector3.h"
 
 namespace Ogre
 {
+class InstancedEntity;
 class SceneNode;
 }
 
@@ -12,7 +15,8 @@ namespace bab
 {
 
 /**
- * Class which wraps a renderable entity created by the GraphicsManager and allows it to be manipulated.
+ * Class which wraps a renderable entity created by the GraphicsManager and allows it to be manipulated. Instanced
+ * entities have no scene node, their transform is written straight to the instance they are drawn from.
  */
 class RenderEntity
 {
@@ -33,6 +37,36 @@ class RenderEntity
      */
     void set_orientation(const Quaternion &set_orientation);
 
+    /**
+     * Set the world position and orientation together.
+     *
+     * @param position
+     *   New world position.
+     *
+     * @param orientation
+     *   New world orientation.
+     */
+    void set_transform(const Vector3 &position, const Quaternion &orientation);
+
+    /**
+     * Set the material of the entity, does nothing for instanced entities as the material is fixed per batch.
+     *
+     * @param material_name
+     *   The name of the material, must already exist.
+     */
+    void set_material(const std::string &material_name);
+
+    /**
+     * Remove the entity from the scene graph so it is no longer rendered or updated, it keeps all its state and can be
+     * put back with attach().
+     */
+    void detach();
+
+    /**
+     * Put a detached entity back into the scene graph.
+     */
+    void attach();
+
   private:
     // allow GraphicsManager to construct this object
     friend class GraphicsManager;
@@ -45,8 +79,19 @@ class RenderEntity
      */
     RenderEntity(::Ogre::SceneNode *node);
 
-    /** Ogre scene node for this entity. */
+    /**
+     * Construct a new instanced RenderEntity, private so only GraphicsManager can call.
+     *
+     * @param instanced_entity
+     *   The ogre instance this entity is drawn from.
+     */
+    RenderEntity(::Ogre::InstancedEntity *instanced_entity);
+
+    /** Ogre scene node for this entity, nullptr if the entity is instanced. */
     ::Ogre::SceneNode *node_;
+
+    /** Ogre instance for this entity, nullptr if the entity is not instanced. */
+    ::Ogre::InstancedEntity *instanced_entity_;
 };
 
 }
@@ -1,21 +1,26 @@
 #pragma once
 
+#include <cstdint>
+
 #include "quaternion.h"
+#include "transform.h"
 #include "vector3.h"
 
-class btRigidBody;
-
 namespace bab
 {
 
+class RigidBodyPool;
+
 /**
- * Class which wraps a rigid body created by the PhysicsManager.
+ * Handle to a rigid body created by the PhysicsManager. Handles are cheap to copy and become invalid once the rigid
+ * body is removed, even if its storage is reused for a new rigid body.
  */
 class RigidBody
 {
   public:
     /**
-     * Get the world space position.
+     * Get the world space position. This reads the simulation directly so must not be called while the PhysicsManager
+     * is running asynchronously, use its TransformSnapshot instead.
      *
      * @returns
      *   Position in world space.
@@ -23,13 +28,82 @@ class RigidBody
     Vector3 position() const;
 
     /**
-     * Get the world space orientation.
+     * Get the world space orientation. This reads the simulation directly so must not be called while the
+     * PhysicsManager is running asynchronously, use its TransformSnapshot instead.
      *
      * @returns
      *   Orientation in world space.
      */
     Quaternion orientation() const;
 
+    /**
+     * Get the world space position interpolated between the last two physics ticks.
+     *
+     * @param alpha
+     *   How far between the previous (0.0) and current (1.0) tick to interpolate.
+     *
+     * @returns
+     *   Interpolated position in world space.
+     */
+    Vector3 interpolated_position(float alpha) const;
+
+    /**
+     * Get the world space orientation interpolated between the last two physics ticks.
+     *
+     * @param alpha
+     *   How far between the previous (0.0) and current (1.0) tick to interpolate.
+     *
+     * @returns
+     *   Interpolated orientation in world space.
+     */
+    Quaternion interpolated_orientation(float alpha) const;
+
+    /**
+     * Get the world space position and orientation interpolated between the last two physics ticks, cheaper than
+     * calling interpolated_position() and interpolated_orientation() separately.
+     *
+     * @param alpha
+     *   How far between the previous (0.0) and current (1.0) tick to interpolate.
+     *
+     * @returns
+     *   Interpolated transform in world space.
+     */
+    Transform interpolated_transform(float alpha) const;
+
+    /**
+     * Check if the handle still refers to a rigid body in the simulation.
+     *
+     * @returns
+     *   True if the rigid body has not been removed, otherwise false.
+     */
+    bool is_valid() const;
+
+    /**
+     * Get the index of the slot storing the rigid body. Indices are dense and stable for the lifetime of the rigid
+     * body, so they can be used to index parallel arrays, but may be reused once the rigid body is removed.
+     *
+     * @returns
+     *   Slot index.
+     */
+    std::uint32_t index() const;
+
+    /**
+     * Get the generation of the slot when the rigid body was created, together with index() this uniquely identifies
+     * the rigid body.
+     *
+     * @returns
+     *   Slot generation.
+     */
+    std::uint32_t generation() const;
+
+    /**
+     * Check if two handles refer to the same rigid body.
+     *
+     * @returns
+     *   True if both handles refer to the same rigid body, otherwise false.
+     */
+    bool operator==(const RigidBody &) const = default;
+
   private:
     // allow PhysicsManager to construct this object
     friend class PhysicsManager;
@@ -37,13 +111,25 @@ class RigidBody
     /**
      * Construct a new RigidBody, private so only PhysicsManager can call.
      *
-     * @param rigid_body
-     *   The bullet rigid body to wrap.
+     * @param pool
+     *   The pool the rigid body is stored in.
+     *
+     * @param index
+     *   Index of the slot the rigid body is stored in.
+     *
+     * @param generation
+     *   Generation of the slot when the rigid body was created.
      */
-    RigidBody(::btRigidBody *rigid_body);
+    RigidBody(RigidBodyPool *pool, std::uint32_t index, std::uint32_t generation);
+
+    /** Pool the rigid body is stored in. */
+    RigidBodyPool *pool_;
+
+    /** Index of the slot in the pool. */
+    std::uint32_t index_;
 
-    /** Bullet rigid body object. */
-    ::btRigidBody *rigid_body_;
+    /** Generation of the slot when the handle was created. */
+    std::uint32_t generation_;
 };
 
 }
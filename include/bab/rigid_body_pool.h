@@ -0,0 +1,223 @@
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+#include "motion_state.h"
+
+#include "BulletCollision/CollisionShapes/btCollisionShape.h"
+#include "BulletDynamics/Dynamics/btRigidBody.h"
+#include "LinearMath/btTransform.h"
+#include "LinearMath/btVector3.h"
+
+namespace bab
+{
+
+/**
+ * Slot map storage for rigid bodies. Each slot keeps a bullet rigid body and its motion state together, slots are
+ * allocated in fixed size blocks so addresses are stable and removed slots are recycled for new bodies. Every slot has
+ * a generation which is bumped on removal, so stale handles can be detected.
+ */
+class RigidBodyPool
+{
+  public:
+    /** Number of slots allocated at a time. */
+    static constexpr std::uint32_t block_size = 256u;
+
+    /**
+     * Construct a new RigidBodyPool.
+     */
+    RigidBodyPool();
+
+    /**
+     * Destroys all remaining rigid bodies, they must have already been removed from the dynamics world.
+     */
+    ~RigidBodyPool();
+
+    // bullet holds pointers into the pool so it cannot be copied or moved
+    RigidBodyPool(const RigidBodyPool &) = delete;
+    RigidBodyPool &operator=(const RigidBodyPool &) = delete;
+
+    /**
+     * Construct a new rigid body and motion state in a free slot.
+     *
+     * @param start_transform
+     *   The initial world transform of the rigid body.
+     *
+     * @param tick
+     *   Reference to the physics tick counter, for the motion state.
+     *
+     * @param dirty_list
+     *   List the motion state adds the slot index to when bullet updates it.
+     *
+     * @param mass
+     *   The mass of the rigid body, zero for static bodies.
+     *
+     * @param shape
+     *   The collision shape of the rigid body.
+     *
+     * @param local_inertia
+     *   The local inertia of the rigid body.
+     *
+     * @returns
+     *   Index of the slot the rigid body was created in.
+     */
+    std::uint32_t create(
+        const ::btTransform &start_transform,
+        const std::uint64_t &tick,
+        std::vector<std::uint32_t> &dirty_list,
+        ::btScalar mass,
+        ::btCollisionShape *shape,
+        const ::btVector3 &local_inertia);
+
+    /**
+     * Destroy the rigid body in a slot and make the slot available for reuse.
+     *
+     * @param index
+     *   Index of the slot to destroy, must be alive.
+     */
+    void destroy(std::uint32_t index);
+
+    /**
+     * Check if a slot holds a rigid body.
+     *
+     * @param index
+     *   Index of the slot to check.
+     *
+     * @returns
+     *   True if the slot holds a rigid body, otherwise false.
+     */
+    bool is_alive(std::uint32_t index) const;
+
+    /**
+     * Check if a slot holds a rigid body of the given generation.
+     *
+     * @param index
+     *   Index of the slot to check.
+     *
+     * @param generation
+     *   The expected generation of the slot.
+     *
+     * @returns
+     *   True if the slot is alive and of the expected generation, otherwise false.
+     */
+    bool is_alive(std::uint32_t index, std::uint32_t generation) const;
+
+    /**
+     * Get the rigid body in a slot.
+     *
+     * @param index
+     *   Index of the slot, must be alive.
+     *
+     * @returns
+     *   Rigid body in the slot.
+     */
+    ::btRigidBody &body(std::uint32_t index) const;
+
+    /**
+     * Get the motion state in a slot.
+     *
+     * @param index
+     *   Index of the slot, must be alive.
+     *
+     * @returns
+     *   Motion state in the slot.
+     */
+    MotionState &motion_state(std::uint32_t index) const;
+
+    /**
+     * Get the current generation of a slot.
+     *
+     * @param index
+     *   Index of the slot.
+     *
+     * @returns
+     *   Generation of the slot.
+     */
+    std::uint32_t generation(std::uint32_t index) const;
+
+    /**
+     * Allocate enough blocks that the next count calls to create() will not allocate.
+     *
+     * @param count
+     *   Number of rigid bodies about to be created.
+     */
+    void reserve(std::uint32_t count);
+
+    /**
+     * Get the total number of slots, alive or free.
+     *
+     * @returns
+     *   Number of slots.
+     */
+    std::uint32_t capacity() const;
+
+    /**
+     * Get the number of alive slots.
+     *
+     * @returns
+     *   Number of alive slots.
+     */
+    std::uint32_t size() const;
+
+  private:
+    /**
+     * Storage for a single rigid body and its motion state.
+     */
+    struct Slot
+    {
+        /** Storage for the bullet rigid body. */
+        alignas(::btRigidBody) std::byte body[sizeof(::btRigidBody)];
+
+        /** Storage for the motion state. */
+        alignas(MotionState) std::byte motion_state[sizeof(MotionState)];
+
+        /** Generation of the slot, bumped every time the slot is destroyed. */
+        std::uint32_t generation;
+
+        /** Index of the next free slot, only valid when the slot is free. */
+        std::uint32_t next_free;
+
+        /** Whether the slot currently holds a rigid body. */
+        bool alive;
+    };
+
+    /**
+     * Contiguous block of slots.
+     */
+    struct Block
+    {
+        /** Slots in the block. */
+        std::array<Slot, block_size> slots;
+    };
+
+    /**
+     * Get a slot by index.
+     *
+     * @param index
+     *   Index of the slot.
+     *
+     * @returns
+     *   Slot at the index.
+     */
+    Slot &slot(std::uint32_t index) const;
+
+    /**
+     * Allocate a new block and thread all of its slots onto the free list.
+     */
+    void add_block();
+
+    /** Allocated blocks of slots. */
+    std::vector<std::unique_ptr<Block>> blocks_;
+
+    /** Index of the first free slot. */
+    std::uint32_t free_head_;
+
+    /** Number of alive slots. */
+    std::uint32_t size_;
+};
+
+}
@@ -0,0 +1,62 @@
+#pragma once
+
+#include <cstdint>
+
+namespace bab
+{
+
+/**
+ * Handle to an entity in a ComponentStore, such as those spawned by the SceneManager. Handles become invalid once the
+ * entity is destroyed, even though its index is recycled for later entities.
+ */
+class SceneEntity
+{
+  public:
+    /**
+     * Get the index of the slot storing the entity, may be reused once the entity is despawned.
+     *
+     * @returns
+     *   Slot index.
+     */
+    std::uint32_t index() const;
+
+    /**
+     * Get the generation of the slot when the entity was spawned, together with index() this uniquely identifies the
+     * entity.
+     *
+     * @returns
+     *   Slot generation.
+     */
+    std::uint32_t generation() const;
+
+    /**
+     * Check if two handles refer to the same entity.
+     *
+     * @returns
+     *   True if both handles refer to the same entity, otherwise false.
+     */
+    bool operator==(const SceneEntity &) const = default;
+
+  private:
+    // allow ComponentStore to construct this object
+    friend class ComponentStore;
+
+    /**
+     * Construct a new SceneEntity, private so only ComponentStore can call.
+     *
+     * @param index
+     *   Index of the slot the entity is stored in.
+     *
+     * @param generation
+     *   Generation of the slot when the entity was spawned.
+     */
+    SceneEntity(std::uint32_t index, std::uint32_t generation);
+
+    /** Index of the slot in the ComponentStore. */
+    std::uint32_t index_;
+
+    /** Generation of the slot when the handle was created. */
+    std::uint32_t generation_;
+};
+
+}
@@ -1,14 +1,23 @@
 #pragma once
 
+#include <cstdint>
 #include <functional>
+#include <map>
+#include <mutex>
+#include <optional>
+#include <span>
 #include <string>
 #include <tuple>
 #include <vector>
 
+#include "component_store.h"
+#include "cube_desc.h"
 #include "debug_drawer.h"
 #include "manual_object.h"
 #include "render_entity.h"
 #include "rigid_body.h"
+#include "scene_entity.h"
+#include "thread_pool.h"
 #include "vector3.h"
 
 namespace bab
@@ -25,18 +34,24 @@ class SceneManager
 {
   public:
     /**
-     * Construct a new SceneManager.
+     * Construct a new SceneManager. Despawns are applied in the "despawn" frame task and transforms are synced in the
+     * "transform_sync" frame task, both run after the frame task named "physics" if there is one.
      *
      * @param gm
      *   The GraphicsManager for the engine.
      *
      * @param pm
      *   The PhysicsManager for the engine.
+     *
+     * @param thread_pool
+     *   Optional pool to split per-frame passes across, must not be shared with an asynchronous PhysicsManager.
      */
-    SceneManager(GraphicsManager &gm, PhysicsManager &pm);
+    SceneManager(GraphicsManager &gm, PhysicsManager &pm, ThreadPool *thread_pool = nullptr);
 
     /**
-     * Add a renderable cube with a physics component, will automatically synch the position and orientation.Position
+     * Add a renderable cube with a physics component, will automatically synch the position and orientation. A
+     * previously despawned cube with the same scale and mass is recycled if there is one, instanced cubes must also
+     * share the material.
      *
      * @param position
      *   World position of the cube.
@@ -52,15 +67,168 @@ class SceneManager
      *
      * @param callback
      *   Optional callback to fire when the physics component collides.
+     *
+     * @param instanced
+     *   Whether to draw the cube with hardware instancing, which keeps the number of draw calls flat as the number of
+     *   cubes grows.
+     *
+     * @returns
+     *   Handle to the new cube.
      */
-    void add_cube(
+    SceneEntity add_cube(
         const Vector3 &position,
         float scale,
         const std::string &material_name,
         float mass,
-        std::function<bool()> callback = nullptr);
+        std::function<bool()> callback = nullptr,
+        bool instanced = false);
+
+    /**
+     * Add many renderable cubes with physics components at once, much quicker than calling add_cube() for each when
+     * loading a level. Despawned cubes are recycled first, the rest are created in a single batch.
+     *
+     * @param descs
+     *   Descriptions of the cubes to add.
+     *
+     * @returns
+     *   Handles to the new cubes, in the same order as descs.
+     */
+    std::vector<SceneEntity> add_cubes(std::span<const CubeDesc> descs);
+
+    /**
+     * Remove an entity from the scene. It is detached from the scene graph and its rigid body taken out of the
+     * simulation, then kept in a pool to be recycled by a later spawn. Despawning an already despawned entity does
+     * nothing.
+     *
+     * The entity is only removed once the frame's physics update, and any collision callbacks it fires, have finished,
+     * so this is safe to call from a collision callback on any thread.
+     *
+     * @param entity
+     *   The entity to despawn.
+     */
+    void despawn(const SceneEntity &entity);
+
+    /**
+     * Get the component store holding every entity in the scene, for attaching extra components such as audio
+     * emitters or user data to spawned cubes. Cubes must still be removed with despawn().
+     *
+     * @returns
+     *   The scene's component store.
+     */
+    ComponentStore &components();
 
   private:
+    /**
+     * The render entity and rigid body of a despawned cube, waiting to be recycled.
+     */
+    struct PooledCube
+    {
+        /** The detached cube. */
+        RenderEntity render_entity;
+
+        /** The cube's rigid body, out of the simulation. */
+        RigidBody rigid_body;
+    };
+
+    /**
+     * Key of the pool a despawned cube is kept in, (scale, mass, material). Scale and mass fix the rigid body's shape,
+     * the material is only part of the key for instanced cubes as theirs cannot be changed and is empty otherwise.
+     */
+    using CubeKey = std::tuple<float, float, std::string>;
+
+    /**
+     * Get the key of the pool a cube belongs in.
+     *
+     * @param scale
+     *   The scale of the cube.
+     *
+     * @param mass
+     *   The mass of the rigid body.
+     *
+     * @param material_name
+     *   The name of the cube's material.
+     *
+     * @param instanced
+     *   Whether the cube is instanced.
+     *
+     * @returns
+     *   Key of the pool.
+     */
+    static CubeKey cube_key(float scale, float mass, const std::string &material_name, bool instanced);
+
+    /**
+     * Take a despawned cube from the pool and put it back into the scene.
+     *
+     * @param position
+     *   World position of the cube.
+     *
+     * @param scale
+     *   The scale of the cube (x, y and z direction).
+     *
+     * @param material_name
+     *   The name of the material to use.
+     *
+     * @param mass
+     *   The mass of the rigid body.
+     *
+     * @param instanced
+     *   Whether the cube is instanced.
+     *
+     * @returns
+     *   Handle to the recycled cube, or empty if the pool had no matching cube.
+     */
+    std::optional<SceneEntity> respawn(
+        const Vector3 &position,
+        float scale,
+        const std::string &material_name,
+        float mass,
+        bool instanced);
+
+    /**
+     * Create an entity for a cube and give it its components.
+     *
+     * @param render_entity
+     *   The rendered cube.
+     *
+     * @param rigid_body
+     *   The cube's rigid body, must be in the simulation.
+     *
+     * @param position
+     *   World position of the cube.
+     *
+     * @param key
+     *   Key of the pool the cube goes back to when despawned.
+     *
+     * @returns
+     *   Handle to the new entity.
+     */
+    SceneEntity spawn(
+        const RenderEntity &render_entity,
+        const RigidBody &rigid_body,
+        const Vector3 &position,
+        CubeKey key);
+
+    /**
+     * Record which entity a rigid body belongs to.
+     *
+     * @param rigid_body
+     *   The rigid body.
+     *
+     * @param entity_index
+     *   Index of the entity in components_, or no entity marker.
+     */
+    void map_rigid_body(const RigidBody &rigid_body, std::uint32_t entity_index);
+
+    /**
+     * Copy every entity's transform component to its render entity.
+     */
+    void apply_transforms();
+
+    /**
+     * Remove every entity queued by despawn().
+     */
+    void flush_despawns();
+
     /** The GraphicsManager for the engine. */
     GraphicsManager &gm_;
 
@@ -73,8 +241,26 @@ class SceneManager
     /** Object used for processing physics debug information. */
     DebugDrawer debug_drawer_;
 
-    /** Collection of added render entities and rigid bodies. */
-    std::vector<std::tuple<RenderEntity, RigidBody>> entities_;
+    /** Components of every entity in the scene. */
+    ComponentStore components_;
+
+    /** Pool key of the cube for each entity index, needed to pick a pool when the cube is despawned. */
+    std::vector<CubeKey> cube_keys_;
+
+    /** Despawned cubes, keyed by what they can be recycled as. */
+    std::map<CubeKey, std::vector<PooledCube>> pools_;
+
+    /** Entity index for each rigid body index, used to find the entities of moved rigid bodies. */
+    std::vector<std::uint32_t> rigid_body_entities_;
+
+    /** Guards pending_despawns_, as collision callbacks may run on the physics thread. */
+    std::mutex despawn_mutex_;
+
+    /** Entities waiting to be despawned. */
+    std::vector<SceneEntity> pending_despawns_;
+
+    /** Scratch storage for the entities being despawned, kept to avoid reallocating every frame. */
+    std::vector<SceneEntity> despawning_;
 };
 
 }
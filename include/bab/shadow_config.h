@@ -0,0 +1,47 @@
+#pragma once
+
+#include <cstdint>
+
+namespace bab
+{
+
+/**
+ * Technique used to render shadows.
+ */
+enum class ShadowTechnique
+{
+    /** No shadows. */
+    NONE,
+
+    /** Stencil volumes with an additive pass per light, exact but extrudes every caster's silhouette on the CPU. */
+    STENCIL_ADDITIVE,
+
+    /** A shadow map per light, darkening the lit scene where it is in shadow. */
+    TEXTURE_MODULATIVE,
+
+    /** Parallel split shadow maps for the directional light, sampled in the generated shaders while lighting. */
+    TEXTURE_PSSM
+};
+
+/**
+ * Settings for how the GraphicsManager renders shadows.
+ */
+struct ShadowConfig
+{
+    /** Technique to render shadows with. */
+    ShadowTechnique technique = ShadowTechnique::STENCIL_ADDITIVE;
+
+    /** Width and height in pixels of each shadow map, ignored by stencil shadows. */
+    std::uint32_t texture_size = 2048u;
+
+    /** Number of shadow maps, for TEXTURE_MODULATIVE this is how many lights can cast shadows at once. */
+    std::uint32_t texture_count = 3u;
+
+    /** Shadows further than this from the camera are not rendered, zero for no limit. */
+    float far_distance = 0.0f;
+
+    /** Objects further than this from the camera do not cast shadows, zero for no limit. */
+    float caster_distance = 0.0f;
+};
+
+}
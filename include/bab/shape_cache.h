@@ -0,0 +1,178 @@
+#pragma once
+
+#include <array>
+#include <compare>
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <utility>
+
+#include "triangle_mesh.h"
+
+#include "BulletCollision/CollisionShapes/btCollisionShape.h"
+#include "LinearMath/btScalar.h"
+#include "LinearMath/btVector3.h"
+
+namespace bab
+{
+
+/**
+ * The kinds of shape the ShapeCache can create.
+ */
+enum class ShapeType
+{
+    BOX,
+    STATIC_PLANE,
+    TRIANGLE_MESH,
+    SCALED_TRIANGLE_MESH
+};
+
+/**
+ * Registry of collision shapes which deduplicates shapes with identical geometry. Shapes are reference counted and
+ * destroyed once the last rigid body using them releases them.
+ */
+class ShapeCache
+{
+  public:
+    /**
+     * Construct a new ShapeCache.
+     */
+    ShapeCache();
+
+    // shapes are handed out by address so the cache cannot be copied or moved
+    ShapeCache(const ShapeCache &) = delete;
+    ShapeCache &operator=(const ShapeCache &) = delete;
+
+    /**
+     * Get a box shape, creating it if no box with the same half extents exists. Each call must be matched with a call
+     * to release().
+     *
+     * @param half_extents
+     *   The half extents of the box.
+     *
+     * @returns
+     *   Shared box shape.
+     */
+    ::btCollisionShape *acquire_box(const ::btVector3 &half_extents);
+
+    /**
+     * Get a static plane shape, creating it if no plane with the same normal and distance exists. Each call must be
+     * matched with a call to release().
+     *
+     * @param normal
+     *   Unit normal of the plane.
+     *
+     * @param distance
+     *   Distance of the plane from the origin along the normal.
+     *
+     * @returns
+     *   Shared plane shape.
+     */
+    ::btCollisionShape *acquire_static_plane(const ::btVector3 &normal, ::btScalar distance);
+
+    /**
+     * Get a static triangle mesh shape for an ogre mesh, creating it if the mesh has not been used at this scale. The
+     * triangles and bvh are shared between all scales of the same mesh. Each call must be matched with a call to
+     * release().
+     *
+     * @param mesh_name
+     *   Name of mesh to load, must exist in a resource location.
+     *
+     * @param scale
+     *   Scale to apply to the mesh.
+     *
+     * @returns
+     *   Shared triangle mesh shape.
+     */
+    ::btCollisionShape *acquire_triangle_mesh(const std::string &mesh_name, const ::btVector3 &scale);
+
+    /**
+     * Release a shape previously returned from one of the acquire functions, destroying it if it is no longer used.
+     *
+     * @param shape
+     *   The shape to release.
+     */
+    void release(const ::btCollisionShape *shape);
+
+    /**
+     * Get the local inertia of a shape for a given mass, the result is calculated once and cached.
+     *
+     * @param shape
+     *   Shape to calculate inertia for, must have been returned from one of the acquire functions.
+     *
+     * @param mass
+     *   The mass of the rigid body using the shape.
+     *
+     * @returns
+     *   Local inertia of the shape.
+     */
+    ::btVector3 local_inertia(const ::btCollisionShape *shape, ::btScalar mass);
+
+    /**
+     * Get the number of unique shapes in the cache.
+     *
+     * @returns
+     *   Number of unique shapes.
+     */
+    std::size_t size() const;
+
+  private:
+    /**
+     * Key which uniquely identifies the geometry of a shape.
+     */
+    struct Key
+    {
+        /** The kind of shape. */
+        ShapeType type;
+
+        /** Parameters which define the geometry, meaning depends on type. */
+        std::array<::btScalar, 4u> parameters;
+
+        /** Name of the asset the geometry comes from, empty for primitive shapes. */
+        std::string name;
+
+        auto operator<=>(const Key &) const = default;
+    };
+
+    /**
+     * A cached shape and how many rigid bodies are using it.
+     */
+    struct Entry
+    {
+        /** Triangles and bvh for triangle mesh shapes, declared before the shape so it outlives it. */
+        std::unique_ptr<TriangleMesh> mesh;
+
+        /** The shared shape. */
+        std::unique_ptr<::btCollisionShape> shape;
+
+        /** Number of outstanding acquires. */
+        std::uint32_t ref_count;
+
+        /** Shape this shape wraps and holds an acquire on, if any. */
+        const ::btCollisionShape *parent;
+    };
+
+    /**
+     * Get a shape for a key, creating it if it does not exist.
+     *
+     * @param key
+     *   The key describing the shape geometry.
+     *
+     * @returns
+     *   Shared shape.
+     */
+    ::btCollisionShape *acquire(const Key &key);
+
+    /** Map of shape geometry to cached shapes. */
+    std::map<Key, Entry> shapes_;
+
+    /** Map of shape addresses back to their cache entry, for release. */
+    std::unordered_map<const ::btCollisionShape *, std::map<Key, Entry>::iterator> entries_;
+
+    /** Map of (shape, mass) to calculated local inertia. */
+    std::map<std::pair<const ::btCollisionShape *, ::btScalar>, ::btVector3> inertia_;
+};
+
+}
@@ -0,0 +1,148 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include "job_system.h"
+
+namespace bab
+{
+
+/**
+ * A set of named tasks run once per frame, where each task only starts once every task it depends on has finished.
+ * Tasks with no ordering between them run in parallel on a JobSystem, except those which must stay on the thread
+ * calling run(), such as anything touching the scene graph.
+ */
+class TaskGraph
+{
+  public:
+    /**
+     * Construct a new TaskGraph.
+     */
+    TaskGraph();
+
+    // tasks in flight hold a pointer to the graph so it cannot be copied or moved
+    TaskGraph(const TaskGraph &) = delete;
+    TaskGraph &operator=(const TaskGraph &) = delete;
+
+    /**
+     * Add a task to the graph. Dependencies which name tasks that were never added are ignored, so a subsystem can
+     * order itself after an optional stage.
+     *
+     * @param name
+     *   Unique name of the task.
+     *
+     * @param dependencies
+     *   Names of the tasks which must finish before this one starts.
+     *
+     * @param task
+     *   The task to run, it is passed the time in seconds since the last frame.
+     *
+     * @param main_thread
+     *   Whether the task must run on the thread calling run(), otherwise it may run on any thread.
+     */
+    void add_task(
+        const std::string &name,
+        const std::vector<std::string> &dependencies,
+        std::function<void(float)> task,
+        bool main_thread);
+
+    /**
+     * Run every task once, blocking until all are complete. The calling thread runs main thread tasks and helps with
+     * queued jobs while it waits, sleeping when there is neither.
+     *
+     * @param delta
+     *   Time in seconds since the last frame, passed to every task.
+     *
+     * @param job_system
+     *   Job system to run tasks which are not tied to the main thread.
+     */
+    void run(float delta, JobSystem &job_system);
+
+  private:
+    /**
+     * A single task and its place in the graph.
+     */
+    struct Task
+    {
+        /** Unique name of the task. */
+        std::string name;
+
+        /** Names of the tasks which must finish first. */
+        std::vector<std::string> dependencies;
+
+        /** The work to run. */
+        std::function<void(float)> work;
+
+        /** Whether the task must run on the thread calling run(). */
+        bool main_thread;
+
+        /** Indices of the tasks which depend on this one, resolved by build(). */
+        std::vector<std::uint32_t> dependants;
+
+        /** Number of dependencies which exist in the graph, resolved by build(). */
+        std::uint32_t dependency_count;
+    };
+
+    /**
+     * Resolve dependency names into indices, checking the graph has no cycles.
+     */
+    void build();
+
+    /**
+     * Hand a task whose dependencies have all finished to the thread that will run it.
+     *
+     * @param index
+     *   Index of the task.
+     *
+     * @param delta
+     *   Time in seconds since the last frame.
+     *
+     * @param job_system
+     *   Job system to run the task on if it is not tied to the main thread.
+     */
+    void schedule(std::uint32_t index, float delta, JobSystem &job_system);
+
+    /**
+     * Run a task then schedule any dependants it was the last dependency of.
+     *
+     * @param index
+     *   Index of the task.
+     *
+     * @param delta
+     *   Time in seconds since the last frame.
+     *
+     * @param job_system
+     *   Job system to run dependants on.
+     */
+    void execute(std::uint32_t index, float delta, JobSystem &job_system);
+
+    /** All tasks, in the order they were added. */
+    std::vector<Task> tasks_;
+
+    /** Whether tasks have been added since the graph was last built. */
+    bool dirty_;
+
+    /** Number of unfinished dependencies of each task during run(). */
+    std::unique_ptr<std::atomic<std::uint32_t>[]> remaining_;
+
+    /** Number of tasks yet to finish during run(). */
+    std::atomic<std::uint32_t> outstanding_;
+
+    /** Guards main_thread_ready_ and sleeping on main_thread_wake_. */
+    std::mutex main_thread_mutex_;
+
+    /** Main thread tasks which are ready to run. */
+    std::vector<std::uint32_t> main_thread_ready_;
+
+    /** Signalled when a main thread task becomes ready or the last task finishes. */
+    std::condition_variable main_thread_wake_;
+};
+
+}
@@ -0,0 +1,153 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <functional>
+
+#include "thread_pool.h"
+
+#include "LinearMath/btScalar.h"
+#include "LinearMath/btThreads.h"
+
+namespace bab
+{
+
+/**
+ * Bullet task scheduler which runs bullet's parallel loops on an engine ThreadPool.
+ *
+ * Bullet hands every thread which runs one of its loops an index from a global counter and sizes its per thread storage
+ * from the thread count, so a pool per world would hand out indices past the end of that storage. Instead there is a
+ * single scheduler and pool for the lifetime of the process, shared by every multithreaded PhysicsManager.
+ */
+class TaskScheduler : public ::btITaskScheduler
+{
+  public:
+    /**
+     * Get the scheduler, creating it and installing it as bullet's scheduler on first use. The first call must be made
+     * from the thread which first used bullet, normally the main thread.
+     *
+     * @returns
+     *   The scheduler.
+     */
+    static TaskScheduler &instance();
+
+    /**
+     * Limit the number of threads loops started from the calling thread run on.
+     *
+     * @param thread_limit
+     *   Maximum number of threads, zero for the whole pool.
+     */
+    static void set_thread_limit(std::uint32_t thread_limit);
+
+    // bullet and the pool's workers hold pointers to the scheduler so it cannot be copied or moved
+    TaskScheduler(const TaskScheduler &) = delete;
+    TaskScheduler &operator=(const TaskScheduler &) = delete;
+
+    /**
+     * Get the pool loops are run on.
+     *
+     * @returns
+     *   The thread pool.
+     */
+    ThreadPool &thread_pool();
+
+    /**
+     * Get the maximum number of threads that can be used.
+     *
+     * @returns
+     *   Number of bullet thread indices in use by the pool.
+     */
+    int getMaxNumThreads() const override;
+
+    /**
+     * Get the number of threads currently being used, bullet sizes its per thread storage from this.
+     *
+     * @returns
+     *   Number of bullet thread indices in use by the pool.
+     */
+    int getNumThreads() const override;
+
+    /**
+     * Does nothing, the pool is shared so its size is fixed. Use set_thread_limit() to run loops on fewer threads.
+     *
+     * @param num_threads
+     *   Ignored.
+     */
+    void setNumThreads(int num_threads) override;
+
+    /**
+     * Run a bullet loop across the pool.
+     *
+     * @param begin
+     *   First index of the loop.
+     *
+     * @param end
+     *   One past the last index of the loop.
+     *
+     * @param grain_size
+     *   Number of indices to hand to a thread at a time.
+     *
+     * @param body
+     *   The loop body.
+     */
+    void parallelFor(int begin, int end, int grain_size, const ::btIParallelForBody &body) override;
+
+    /**
+     * Run a bullet loop across the pool and sum the results of each chunk.
+     *
+     * @param begin
+     *   First index of the loop.
+     *
+     * @param end
+     *   One past the last index of the loop.
+     *
+     * @param grain_size
+     *   Number of indices to hand to a thread at a time.
+     *
+     * @param body
+     *   The loop body.
+     *
+     * @returns
+     *   Sum of all chunks.
+     */
+    ::btScalar parallelSum(int begin, int end, int grain_size, const ::btIParallelSumBody &body) override;
+
+  private:
+    /**
+     * Construct a new TaskScheduler, claiming bullet thread indices for the calling thread and every worker.
+     */
+    TaskScheduler();
+
+    /**
+     * Claim a bullet thread index for the calling pool worker.
+     */
+    void claim_slot();
+
+    /**
+     * Run a loop across the pool, on the calling thread too if it owns a bullet thread index.
+     *
+     * @param begin
+     *   First index of the loop.
+     *
+     * @param end
+     *   One past the last index of the loop.
+     *
+     * @param grain_size
+     *   Number of indices to hand to a thread at a time.
+     *
+     * @param body
+     *   Function to call for each chunk.
+     */
+    void run(int begin, int end, int grain_size, const std::function<void(std::int32_t, std::int32_t)> &body);
+
+    /** Highest bullet thread index claimed by the pool, declared before the pool as its workers write it. */
+    std::atomic<unsigned int> highest_index_;
+
+    /** Pool to run loops on. */
+    ThreadPool thread_pool_;
+
+    /** Number of bullet thread indices the pool's threads may use. */
+    int slot_count_;
+};
+
+}
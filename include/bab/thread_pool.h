@@ -0,0 +1,132 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <stop_token>
+#include <thread>
+#include <vector>
+
+namespace bab
+{
+
+/**
+ * Pool of worker threads for splitting loops across cores. The thread calling parallel_for() normally also takes part
+ * in the work, so a pool of N threads spawns N - 1 workers. Loops started from different threads run one at a time.
+ */
+class ThreadPool
+{
+  public:
+    /**
+     * Construct a new ThreadPool.
+     *
+     * @param thread_count
+     *   Total number of threads to run work on, including the calling thread.
+     *
+     * @param on_worker_start
+     *   Optional function each worker calls once when it starts, before it runs any work. The constructor does not
+     *   return until every worker has called it.
+     */
+    ThreadPool(std::uint32_t thread_count, const std::function<void()> &on_worker_start = nullptr);
+
+    /**
+     * Stops and joins all worker threads.
+     */
+    ~ThreadPool();
+
+    // workers hold a pointer to the pool so it cannot be copied or moved
+    ThreadPool(const ThreadPool &) = delete;
+    ThreadPool &operator=(const ThreadPool &) = delete;
+
+    /**
+     * Get the total number of threads work is run on, including the calling thread.
+     *
+     * @returns
+     *   Number of threads.
+     */
+    std::uint32_t thread_count() const;
+
+    /**
+     * Run a loop split into chunks across all threads, blocking until every chunk is complete. Calls made from inside
+     * a running loop are run serially on the calling thread.
+     *
+     * @param begin
+     *   First index of the loop.
+     *
+     * @param end
+     *   One past the last index of the loop.
+     *
+     * @param grain_size
+     *   Number of indices to hand to a thread at a time.
+     *
+     * @param body
+     *   Function to call for each chunk with the range [begin, end) to process.
+     *
+     * @param max_threads
+     *   Maximum number of threads to run the loop on, zero for all of them.
+     *
+     * @param run_on_caller
+     *   Whether the calling thread takes part in the loop, if false it only waits for the workers.
+     */
+    void parallel_for(
+        std::int32_t begin,
+        std::int32_t end,
+        std::int32_t grain_size,
+        const std::function<void(std::int32_t, std::int32_t)> &body,
+        std::uint32_t max_threads = 0u,
+        bool run_on_caller = true);
+
+  private:
+    /**
+     * Main loop for worker threads, waits for work and runs chunks until stopped.
+     *
+     * @param stop_token
+     *   Token signalled when the pool is destroyed.
+     */
+    void worker_loop(std::stop_token stop_token);
+
+    /**
+     * Claim and run chunks of the current loop until there are none left.
+     */
+    void run_chunks();
+
+    /** Worker threads. */
+    std::vector<std::jthread> workers_;
+
+    /** Held for the whole of a loop, so loops started from different threads do not overwrite each other's state. */
+    std::mutex loop_mutex_;
+
+    /** Guards job state shared with workers. */
+    std::mutex mutex_;
+
+    /** Signalled when a new loop is available. */
+    std::condition_variable_any work_available_;
+
+    /** Signalled when the last worker finishes a loop. */
+    std::condition_variable work_complete_;
+
+    /** The body of the current loop. */
+    const std::function<void(std::int32_t, std::int32_t)> *body_;
+
+    /** Next index to hand out. */
+    std::atomic<std::int32_t> next_;
+
+    /** One past the last index of the current loop. */
+    std::int32_t end_;
+
+    /** Chunk size of the current loop. */
+    std::int32_t grain_size_;
+
+    /** Incremented for every loop, so workers can tell a new loop has been posted. */
+    std::uint64_t job_id_;
+
+    /** Number of workers still running the current loop. */
+    std::uint32_t busy_workers_;
+
+    /** Number of workers still allowed to join the current loop. */
+    std::atomic<std::int32_t> open_slots_;
+};
+
+}
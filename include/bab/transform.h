@@ -0,0 +1,21 @@
+#pragma once
+
+#include "quaternion.h"
+#include "vector3.h"
+
+namespace bab
+{
+
+/**
+ * Position and orientation of an object in world space.
+ */
+struct Transform
+{
+    /** World space position. */
+    Vector3 position;
+
+    /** World space orientation. */
+    Quaternion orientation;
+};
+
+}
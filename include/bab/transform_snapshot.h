@@ -0,0 +1,86 @@
+#pragma once
+
+#include <chrono>
+#include <cstdint>
+#include <optional>
+#include <vector>
+
+#include "rigid_body.h"
+#include "transform.h"
+#include "vector3.h"
+
+namespace bab
+{
+
+/**
+ * Immutable copy of every rigid body transform after a physics tick, published by the PhysicsManager when it runs
+ * asynchronously. Holds the last two ticks so transforms can be interpolated.
+ */
+class TransformSnapshot
+{
+  public:
+    /**
+     * Construct a new, empty, TransformSnapshot.
+     */
+    TransformSnapshot();
+
+    /**
+     * Get the tick the snapshot was taken after.
+     *
+     * @returns
+     *   Tick of the snapshot.
+     */
+    std::uint64_t tick() const;
+
+    /**
+     * Get how far between the snapshot's previous and current tick a point in time is.
+     *
+     * @param now
+     *   The point in time to calculate for.
+     *
+     * @returns
+     *   Value in the range [0.0, 1.0] where 0.0 is the previous tick and 1.0 the current tick.
+     */
+    float interpolation_alpha(std::chrono::steady_clock::time_point now) const;
+
+    /**
+     * Get the transform of a rigid body interpolated between the snapshot's previous and current tick.
+     *
+     * @param rigid_body
+     *   The rigid body to get the transform of.
+     *
+     * @param alpha
+     *   How far between the previous (0.0) and current (1.0) tick to interpolate.
+     *
+     * @returns
+     *   Interpolated transform, or an empty optional if the rigid body is not in the snapshot.
+     */
+    std::optional<Transform> interpolated_transform(const RigidBody &rigid_body, float alpha) const;
+
+  private:
+    // allow PhysicsManager to fill in the snapshot
+    friend class PhysicsManager;
+
+    /** Tick the snapshot was taken after. */
+    std::uint64_t tick_;
+
+    /** Real time the snapshot was published. */
+    std::chrono::steady_clock::time_point published_;
+
+    /** Length of a tick in seconds. */
+    float tick_length_;
+
+    /** Generation of each rigid body slot, used to reject stale handles. */
+    std::vector<std::uint32_t> generations_;
+
+    /** Transform of each rigid body slot at the previous tick. */
+    std::vector<Transform> previous_;
+
+    /** Transform of each rigid body slot at the snapshot's tick. */
+    std::vector<Transform> current_;
+
+    /** Debug lines drawn at the snapshot's tick as consecutive start, end and colour triples, empty if not drawing. */
+    std::vector<Vector3> debug_lines_;
+};
+
+}
@@ -0,0 +1,109 @@
+#pragma once
+
+#include <cstdint>
+#include <filesystem>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "BulletCollision/CollisionShapes/btBvhTriangleMeshShape.h"
+#include "BulletCollision/CollisionShapes/btOptimizedBvh.h"
+#include "BulletCollision/CollisionShapes/btTriangleIndexVertexArray.h"
+#include "LinearMath/btVector3.h"
+
+namespace bab
+{
+
+/**
+ * Triangle soup copied out of an ogre mesh, along with the quantised bvh bullet needs to collide with it. Building the
+ * bvh for a large mesh is slow, so it is serialised to a cache file next to the mesh asset and loaded from there when
+ * the mesh has not changed.
+ */
+class TriangleMesh
+{
+  public:
+    /**
+     * Construct a new TriangleMesh, loading the ogre mesh if it is not already loaded.
+     *
+     * @param mesh_name
+     *   Name of mesh to load, must exist in a resource location.
+     */
+    TriangleMesh(const std::string &mesh_name);
+
+    /**
+     * TriangleMesh specific cleanup.
+     */
+    ~TriangleMesh();
+
+    // bullet holds pointers to the vertex data and bvh so the mesh cannot be copied or moved
+    TriangleMesh(const TriangleMesh &) = delete;
+    TriangleMesh &operator=(const TriangleMesh &) = delete;
+
+    /**
+     * Create a new collision shape for the mesh, the shape shares the mesh's data so must not outlive it.
+     *
+     * @returns
+     *   New collision shape.
+     */
+    std::unique_ptr<::btBvhTriangleMeshShape> create_shape();
+
+  private:
+    /**
+     * Deleter for memory from btAlignedAlloc.
+     */
+    struct AlignedDeleter
+    {
+        void operator()(void *buffer) const;
+    };
+
+    /**
+     * Try to load the bvh from the cache file.
+     *
+     * @param cache_path
+     *   Path of the cache file.
+     *
+     * @param content_hash
+     *   Hash of the mesh data the cache must have been written for.
+     *
+     * @returns
+     *   True if the bvh was loaded, otherwise false.
+     */
+    bool load_bvh(const std::filesystem::path &cache_path, std::uint64_t content_hash);
+
+    /**
+     * Write the bvh to the cache file, failing to write is not an error as the bvh is simply rebuilt next time.
+     *
+     * @param cache_path
+     *   Path of the cache file.
+     *
+     * @param content_hash
+     *   Hash of the mesh data the bvh was built for.
+     */
+    void save_bvh(const std::filesystem::path &cache_path, std::uint64_t content_hash) const;
+
+    /** Vertex positions, three floats per vertex. */
+    std::vector<float> vertices_;
+
+    /** Triangle indices, three per triangle. */
+    std::vector<int> indices_;
+
+    /** Bullet view of the vertices and indices. */
+    ::btTriangleIndexVertexArray mesh_interface_;
+
+    /** Minimum corner of the mesh bounds, used to quantise the bvh. */
+    ::btVector3 aabb_min_;
+
+    /** Maximum corner of the mesh bounds. */
+    ::btVector3 aabb_max_;
+
+    /** Bvh built at runtime, null if it was loaded from the cache. */
+    std::unique_ptr<::btOptimizedBvh> built_bvh_;
+
+    /** Cache file contents the loaded bvh lives in, null if it was built. */
+    std::unique_ptr<void, AlignedDeleter> bvh_buffer_;
+
+    /** The bvh in use, points to either built_bvh_ or into bvh_buffer_. */
+    ::btOptimizedBvh *bvh_;
+};
+
+}
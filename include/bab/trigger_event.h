@@ -0,0 +1,36 @@
+#pragma once
+
+#include "rigid_body.h"
+#include "trigger_volume.h"
+
+namespace bab
+{
+
+/**
+ * The kind of change a TriggerEvent describes.
+ */
+enum class TriggerEventType
+{
+    /** The rigid body started overlapping the trigger volume this tick. */
+    ENTER,
+
+    /** The rigid body overlapped the trigger volume last tick but no longer does, or was removed. */
+    EXIT
+};
+
+/**
+ * Describes a rigid body entering or leaving a trigger volume during a physics tick.
+ */
+struct TriggerEvent
+{
+    /** What happened between the trigger volume and the rigid body. */
+    TriggerEventType type;
+
+    /** The trigger volume. */
+    TriggerVolume trigger;
+
+    /** The rigid body, for EXIT events this may no longer be valid. */
+    RigidBody body;
+};
+
+}
@@ -0,0 +1,62 @@
+#pragma once
+
+#include <cstdint>
+
+namespace bab
+{
+
+/**
+ * Handle to a trigger volume created by the PhysicsManager. A trigger volume has no collision response, it only
+ * reports rigid bodies entering and leaving it.
+ */
+class TriggerVolume
+{
+  public:
+    /**
+     * Get the index of the slot storing the trigger volume, may be reused once the trigger volume is removed.
+     *
+     * @returns
+     *   Slot index.
+     */
+    std::uint32_t index() const;
+
+    /**
+     * Get the generation of the slot when the trigger volume was created, together with index() this uniquely
+     * identifies the trigger volume.
+     *
+     * @returns
+     *   Slot generation.
+     */
+    std::uint32_t generation() const;
+
+    /**
+     * Check if two handles refer to the same trigger volume.
+     *
+     * @returns
+     *   True if both handles refer to the same trigger volume, otherwise false.
+     */
+    bool operator==(const TriggerVolume &) const = default;
+
+  private:
+    // allow PhysicsManager to construct this object
+    friend class PhysicsManager;
+
+    /**
+     * Construct a new TriggerVolume, private so only PhysicsManager can call.
+     *
+     * @param index
+     *   Index of the slot the trigger volume is stored in.
+     *
+     * @param generation
+     *   Generation of the slot when the trigger volume was created.
+     */
+    TriggerVolume(std::uint32_t index, std::uint32_t generation);
+
+    /** Index of the slot in the PhysicsManager. */
+    std::uint32_t index_;
+
+    /** Generation of the slot when the handle was created. */
+    std::uint32_t generation_;
+};
+
+}
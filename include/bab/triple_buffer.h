@@ -0,0 +1,85 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <cstdint>
+
+namespace bab
+{
+
+/**
+ * Lock free triple buffer for handing values from a single writer thread to a single reader thread. The writer fills
+ * the write buffer and publishes it, the reader always sees the most recently published value and neither side ever
+ * blocks the other.
+ */
+template <class T>
+class TripleBuffer
+{
+  public:
+    /**
+     * Construct a new TripleBuffer.
+     */
+    TripleBuffer()
+        : buffers_()
+        , middle_(1u)
+        , write_(0u)
+        , read_(2u)
+    {
+    }
+
+    /**
+     * Get the buffer the writer should fill, only the writer thread may call this.
+     *
+     * @returns
+     *   Buffer to write to, contains whatever value was last published from it.
+     */
+    T &write_buffer()
+    {
+        return buffers_[write_];
+    }
+
+    /**
+     * Publish the write buffer so the reader can see it, only the writer thread may call this.
+     */
+    void publish()
+    {
+        write_ = middle_.exchange(write_ | fresh_bit, std::memory_order_acq_rel) & index_mask;
+    }
+
+    /**
+     * Get the most recently published value, only the reader thread may call this.
+     *
+     * @returns
+     *   Most recently published value, which stays valid until the next call.
+     */
+    const T &read()
+    {
+        if ((middle_.load(std::memory_order_relaxed) & fresh_bit) != 0u)
+        {
+            read_ = middle_.exchange(read_, std::memory_order_acq_rel) & index_mask;
+        }
+
+        return buffers_[read_];
+    }
+
+  private:
+    /** Bit set in middle_ when it holds a value the reader has not seen. */
+    static constexpr std::uint8_t fresh_bit = 0x4u;
+
+    /** Mask for the buffer index in middle_. */
+    static constexpr std::uint8_t index_mask = 0x3u;
+
+    /** The three buffers. */
+    std::array<T, 3u> buffers_;
+
+    /** Index of the buffer between the writer and the reader, plus the fresh bit. */
+    std::atomic<std::uint8_t> middle_;
+
+    /** Index of the buffer owned by the writer. */
+    std::uint8_t write_;
+
+    /** Index of the buffer owned by the reader. */
+    std::uint8_t read_;
+};
+
+}
@@ -0,0 +1,128 @@
+#include "entry.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <iostream>
+#include <string_view>
+#include <vector>
+
+#include "cube_desc.h"
+#include "graphics_config.h"
+#include "graphics_manager.h"
+#include "physics_manager.h"
+#include "scene_manager.h"
+#include "vector3.h"
+
+namespace
+{
+
+/** Number of frames to render after each batch, so the draw call count is from a settled frame. */
+constexpr auto frames_per_batch = 3u;
+
+/**
+ * Build a batch of cubes laid out on a grid above the ground, continuing on from the cubes already added.
+ *
+ * @param first
+ *   Index of the first cube in the batch.
+ *
+ * @param count
+ *   Number of cubes in the batch.
+ *
+ * @param instanced
+ *   Whether the cubes are drawn with hardware instancing.
+ *
+ * @returns
+ *   Descriptions of the cubes.
+ */
+std::vector<bab::CubeDesc> cube_batch(std::uint32_t first, std::uint32_t count, bool instanced)
+{
+    constexpr auto grid_size = 100u;
+    constexpr auto spacing = 15.0f;
+    constexpr auto grid_offset = static_cast<float>(grid_size) * spacing * 0.5f;
+
+    std::vector<bab::CubeDesc> descs{};
+    descs.reserve(count);
+
+    for (auto i = first; i < first + count; ++i)
+    {
+        const auto layer = i / (grid_size * grid_size);
+        const auto cell = i % (grid_size * grid_size);
+
+        const bab::Vector3 position{
+            static_cast<float>(cell % grid_size) * spacing - grid_offset,
+            200.0f + static_cast<float>(layer) * spacing,
+            static_cast<float>(cell / grid_size) * spacing - grid_offset};
+
+        descs.push_back({position, 0.1f, "box_material", 1.0f, instanced});
+    }
+
+    return descs;
+}
+
+}
+
+/**
+ * Add ever larger numbers of cubes through the SceneManager, printing the draw calls needed to render them as csv. Pass
+ * --plain to draw the cubes without instancing for comparison, or --headless to render a few small batches offscreen
+ * with the software render system and check every captured frame is the right size, for machines with no GPU.
+ */
+int main(int argc, char **argv)
+{
+    auto plain = false;
+    auto headless = false;
+
+    for (auto i = 1; i < argc; ++i)
+    {
+        const std::string_view arg{argv[i]};
+        plain |= (arg == "--plain");
+        headless |= (arg == "--headless");
+    }
+
+    // the software render system has no shaders, so it can't instance
+    const auto instanced = !plain && !headless;
+
+    bab::GraphicsConfig config{};
+    config.headless = headless;
+
+    bab::GraphicsManager gm{config};
+    gm.add_material("box_material", "box.png");
+
+    bab::PhysicsManager pm{};
+    gm.add_frame_task("physics", {}, [&pm](float delta) { pm.update(delta); });
+
+    bab::SceneManager sm{gm, pm};
+
+    const auto targets = headless ? std::vector<std::uint32_t>{100u, 200u, 400u}
+                                  : std::vector<std::uint32_t>{1000u, 2000u, 4000u, 8000u, 16000u};
+
+    std::cout << "cubes,instanced,draw_calls" << std::endl;
+
+    auto cube_count = 0u;
+    for (const auto target : targets)
+    {
+        sm.add_cubes(cube_batch(cube_count, target - cube_count, instanced));
+        cube_count = target;
+
+        for (auto i = 0u; i < frames_per_batch; ++i)
+        {
+            if (!gm.render_frame())
+            {
+                return 0;
+            }
+        }
+
+        if (headless)
+        {
+            const auto expected_size = static_cast<std::size_t>(gm.frame_width()) * gm.frame_height() * 4u;
+            if (const auto size = gm.capture_frame().size(); size != expected_size)
+            {
+                std::cerr << "captured " << size << " bytes, expected " << expected_size << std::endl;
+                return 1;
+            }
+        }
+
+        std::cout << cube_count << "," << instanced << "," << gm.draw_call_count() << std::endl;
+    }
+
+    return 0;
+}
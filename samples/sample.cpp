@@ -9,19 +9,25 @@
 #include "colour.h"
 #include "degree.h"
 #include "graphics_manager.h"
+#include "mesh_lod_settings.h"
 #include "physics_manager.h"
 #include "quaternion.h"
 #include "radian.h"
 #include "scene_manager.h"
+#include "shadow_config.h"
 #include "vector3.h"
 
 int main()
 {
     bab::GraphicsManager gm{};
 
+    gm.set_shadows({bab::ShadowTechnique::TEXTURE_PSSM, 2048u, 3u, 2000.0f, 1500.0f});
     gm.set_sky_dome("Examples/CloudySky", 5.0f, 8.0f);
-    gm.add_mesh("ninja.mesh", bab::Vector3::ZERO, {bab::Radian{std::numbers::pi_v<float>}, bab::Vector3::UNIT_Y}, true);
-    gm.add_plane(1500.0f, 1500.0f, 20u, 20u, false, "Examples/Rockwall");
+    gm.set_mesh_lod({bab::MeshLodStrategy::DISTANCE, {{500.0f, 0.5f}, {1000.0f, 0.8f}}});
+    gm.add_static_mesh(
+        "ninja.mesh", bab::Vector3::ZERO, {bab::Radian{std::numbers::pi_v<float>}, bab::Vector3::UNIT_Y}, true);
+    gm.add_static_plane(1500.0f, 1500.0f, 20u, 20u, false, "Examples/Rockwall");
+    gm.build_static_geometry({500.0f, 500.0f, 500.0f});
     gm.add_material("box_material", "box.png");
     gm.add_spot_light(
         {200.0f, 200.0f, 0.0f}, {-1.0f, -1.0f, 0.0f}, bab::Colour::Blue, bab::Degree{35.0f}, bab::Degree{50.0f});
@@ -30,7 +36,9 @@ int main()
 
     bab::PhysicsManager pm{};
     pm.add_static_rigid_body({750.0f, 0.0f, 750.0f}, bab::Vector3::ZERO);
-    gm.register_frame_start_callback([&pm] { pm.update(); });
+    pm.add_static_mesh_rigid_body(
+        "ninja.mesh", bab::Vector3::ZERO, {bab::Radian{std::numbers::pi_v<float>}, bab::Vector3::UNIT_Y});
+    gm.add_frame_task("physics", {}, [&pm](float delta) { pm.update(delta); });
 
     bab::AudioManager am{};
     const auto *clip = am.load("assets/box-crash.wav");
@@ -0,0 +1,129 @@
+#include "box_plane_collision_algorithm.h"
+
+#include <new>
+
+#include "BulletCollision/BroadphaseCollision/btCollisionAlgorithm.h"
+#include "BulletCollision/CollisionDispatch/btActivatingCollisionAlgorithm.h"
+#include "BulletCollision/CollisionDispatch/btCollisionObjectWrapper.h"
+#include "BulletCollision/CollisionDispatch/btManifoldResult.h"
+#include "BulletCollision/CollisionShapes/btBoxShape.h"
+#include "BulletCollision/CollisionShapes/btStaticPlaneShape.h"
+#include "BulletCollision/NarrowPhaseCollision/btPersistentManifold.h"
+#include "LinearMath/btScalar.h"
+#include "LinearMath/btTransform.h"
+#include "LinearMath/btVector3.h"
+
+namespace bab
+{
+
+BoxPlaneCollisionAlgorithm::BoxPlaneCollisionAlgorithm(
+    const ::btCollisionAlgorithmConstructionInfo &construction_info,
+    const ::btCollisionObjectWrapper *body0_wrap,
+    const ::btCollisionObjectWrapper *body1_wrap,
+    bool swapped)
+    : ::btActivatingCollisionAlgorithm(construction_info, body0_wrap, body1_wrap)
+    , manifold_(nullptr)
+    , swapped_(swapped)
+{
+    const auto *box_wrap = swapped_ ? body1_wrap : body0_wrap;
+    const auto *plane_wrap = swapped_ ? body0_wrap : body1_wrap;
+
+    // the manifold always has the plane as its second object, so contacts are reported relative to the plane
+    if (m_dispatcher->needsCollision(box_wrap->getCollisionObject(), plane_wrap->getCollisionObject()))
+    {
+        manifold_ = m_dispatcher->getNewManifold(box_wrap->getCollisionObject(), plane_wrap->getCollisionObject());
+    }
+}
+
+BoxPlaneCollisionAlgorithm::~BoxPlaneCollisionAlgorithm()
+{
+    if (manifold_ != nullptr)
+    {
+        m_dispatcher->releaseManifold(manifold_);
+    }
+}
+
+void BoxPlaneCollisionAlgorithm::processCollision(
+    const ::btCollisionObjectWrapper *body0_wrap,
+    const ::btCollisionObjectWrapper *body1_wrap,
+    const ::btDispatcherInfo &,
+    ::btManifoldResult *result)
+{
+    if (manifold_ == nullptr)
+    {
+        return;
+    }
+
+    const auto *box_wrap = swapped_ ? body1_wrap : body0_wrap;
+    const auto *plane_wrap = swapped_ ? body0_wrap : body1_wrap;
+
+    const auto *box = static_cast<const ::btBoxShape *>(box_wrap->getCollisionShape());
+    const auto *plane = static_cast<const ::btStaticPlaneShape *>(plane_wrap->getCollisionShape());
+
+    const auto &plane_transform = plane_wrap->getWorldTransform();
+    const auto normal = plane_transform.getBasis() * plane->getPlaneNormal();
+    const auto plane_point = plane_transform * (plane->getPlaneNormal() * plane->getPlaneConstant());
+
+    const auto &box_transform = box_wrap->getWorldTransform();
+    const auto half_extents = box->getHalfExtentsWithMargin();
+    const auto threshold = manifold_->getContactBreakingThreshold();
+
+    result->setPersistentManifold(manifold_);
+
+    // the box's extent along the normal bounds how close any corner can be, so most boxes resting on something other
+    // than the plane are rejected without looking at their corners
+    const auto radius = half_extents.dot((normal * box_transform.getBasis()).absolute());
+    if ((normal.dot(box_transform.getOrigin() - plane_point) - radius) > threshold)
+    {
+        manifold_->clearManifold();
+        return;
+    }
+
+    for (auto corner = 0; corner < 8; ++corner)
+    {
+        const ::btVector3 local_corner{
+            (corner & 1) ? half_extents.getX() : -half_extents.getX(),
+            (corner & 2) ? half_extents.getY() : -half_extents.getY(),
+            (corner & 4) ? half_extents.getZ() : -half_extents.getZ()};
+
+        const auto world_corner = box_transform * local_corner;
+        const auto distance = normal.dot(world_corner - plane_point);
+
+        // the manifold keeps the deepest and widest spread four, so a box lying flat ends up with one per corner
+        if (distance < threshold)
+        {
+            result->addContactPoint(normal, world_corner - (normal * distance), distance);
+        }
+    }
+
+    result->refreshContactPoints();
+}
+
+::btScalar BoxPlaneCollisionAlgorithm::calculateTimeOfImpact(
+    ::btCollisionObject *,
+    ::btCollisionObject *,
+    const ::btDispatcherInfo &,
+    ::btManifoldResult *)
+{
+    return 1.0f;
+}
+
+void BoxPlaneCollisionAlgorithm::getAllContactManifolds(::btManifoldArray &manifolds)
+{
+    if (manifold_ != nullptr)
+    {
+        manifolds.push_back(manifold_);
+    }
+}
+
+::btCollisionAlgorithm *BoxPlaneCollisionAlgorithm::CreateFunc::CreateCollisionAlgorithm(
+    ::btCollisionAlgorithmConstructionInfo &construction_info,
+    const ::btCollisionObjectWrapper *body0_wrap,
+    const ::btCollisionObjectWrapper *body1_wrap)
+{
+    // bullet pools algorithm memory in the dispatcher, so construct in place rather than with new
+    auto *memory = construction_info.m_dispatcher1->allocateCollisionAlgorithm(sizeof(BoxPlaneCollisionAlgorithm));
+    return new (memory) BoxPlaneCollisionAlgorithm(construction_info, body0_wrap, body1_wrap, m_swapped);
+}
+
+}
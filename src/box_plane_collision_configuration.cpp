@@ -0,0 +1,38 @@
+#include "box_plane_collision_configuration.h"
+
+#include "box_plane_collision_algorithm.h"
+
+#include "BulletCollision/BroadphaseCollision/btBroadphaseProxy.h"
+#include "BulletCollision/CollisionDispatch/btCollisionCreateFunc.h"
+#include "BulletCollision/CollisionDispatch/btDefaultCollisionConfiguration.h"
+
+namespace bab
+{
+
+BoxPlaneCollisionConfiguration::BoxPlaneCollisionConfiguration()
+    : ::btDefaultCollisionConfiguration()
+    , box_plane_create_func_()
+    , plane_box_create_func_()
+{
+    // bullet passes the pair to the algorithm in dispatch order, so flag which factory sees the plane first
+    plane_box_create_func_.m_swapped = true;
+}
+
+::btCollisionAlgorithmCreateFunc *BoxPlaneCollisionConfiguration::getCollisionAlgorithmCreateFunc(
+    int proxy_type0,
+    int proxy_type1)
+{
+    if ((proxy_type0 == BOX_SHAPE_PROXYTYPE) && (proxy_type1 == STATIC_PLANE_PROXYTYPE))
+    {
+        return &box_plane_create_func_;
+    }
+
+    if ((proxy_type0 == STATIC_PLANE_PROXYTYPE) && (proxy_type1 == BOX_SHAPE_PROXYTYPE))
+    {
+        return &plane_box_create_func_;
+    }
+
+    return ::btDefaultCollisionConfiguration::getCollisionAlgorithmCreateFunc(proxy_type0, proxy_type1);
+}
+
+}
@@ -0,0 +1,75 @@
+#include "collision_layers.h"
+
+#include <algorithm>
+#include <cassert>
+#include <cstdint>
+#include <iterator>
+#include <string>
+
+namespace
+{
+
+/** Mask which collides with every layer. */
+constexpr auto all_layers = ~std::uint32_t{0u};
+
+}
+
+namespace bab
+{
+
+CollisionLayers::CollisionLayers()
+    : names_({"default", "static", "kinematic", "debris", "sensor", "character"})
+    , masks_()
+{
+    masks_.fill(all_layers);
+
+    // static geometry never moves so there is no point testing it against itself
+    set_collides("static", "static", false);
+}
+
+std::uint32_t CollisionLayers::add(const std::string &name)
+{
+    assert(names_.size() < max_layers);
+    assert(std::ranges::find(names_, name) == std::cend(names_));
+
+    names_.push_back(name);
+    return layer(name);
+}
+
+std::uint32_t CollisionLayers::layer(const std::string &name) const
+{
+    return 1u << index_of(name);
+}
+
+void CollisionLayers::set_collides(const std::string &layer_a, const std::string &layer_b, bool collides)
+{
+    const auto index_a = index_of(layer_a);
+    const auto index_b = index_of(layer_b);
+
+    if (collides)
+    {
+        masks_[index_a] |= 1u << index_b;
+        masks_[index_b] |= 1u << index_a;
+    }
+    else
+    {
+        masks_[index_a] &= ~(1u << index_b);
+        masks_[index_b] &= ~(1u << index_a);
+    }
+}
+
+CollisionFilter CollisionLayers::filter(const std::string &name) const
+{
+    const auto index = index_of(name);
+    return {1u << index, masks_[index]};
+}
+
+std::uint32_t CollisionLayers::index_of(const std::string &name) const
+{
+    const auto layer = std::ranges::find(names_, name);
+    assert(layer != std::cend(names_));
+
+    return static_cast<std::uint32_t>(std::distance(std::cbegin(names_), layer));
+}
+
+}
@@ -0,0 +1,110 @@
+#include "component_store.h"
+
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+
+#include "audio_clip.h"
+#include "component_array.h"
+#include "render_entity.h"
+#include "rigid_body.h"
+#include "scene_entity.h"
+#include "thread_pool.h"
+#include "transform.h"
+
+namespace bab
+{
+
+ComponentStore::ComponentStore(ThreadPool *thread_pool)
+    : thread_pool_(thread_pool)
+    , generations_()
+    , alive_()
+    , free_indices_()
+    , transforms_()
+    , rigid_bodies_()
+    , render_entities_()
+    , audio_emitters_()
+    , user_data_()
+{
+}
+
+SceneEntity ComponentStore::create()
+{
+    if (free_indices_.empty())
+    {
+        generations_.push_back(0u);
+        alive_.push_back(true);
+
+        return {static_cast<std::uint32_t>(generations_.size() - 1u), 0u};
+    }
+
+    const auto index = free_indices_.back();
+    free_indices_.pop_back();
+    alive_[index] = true;
+
+    return {index, generations_[index]};
+}
+
+void ComponentStore::destroy(const SceneEntity &entity)
+{
+    if (!is_alive(entity))
+    {
+        return;
+    }
+
+    const auto index = entity.index_;
+
+    transforms_.erase(index);
+    rigid_bodies_.erase(index);
+    render_entities_.erase(index);
+    audio_emitters_.erase(index);
+    user_data_.erase(index);
+
+    alive_[index] = false;
+    ++generations_[index];
+    free_indices_.push_back(index);
+}
+
+bool ComponentStore::is_alive(const SceneEntity &entity) const
+{
+    return (entity.index_ < generations_.size()) && alive_[entity.index_] &&
+           (generations_[entity.index_] == entity.generation_);
+}
+
+SceneEntity ComponentStore::entity(std::uint32_t index) const
+{
+    assert((index < alive_.size()) && alive_[index]);
+    return {index, generations_[index]};
+}
+
+std::size_t ComponentStore::size() const
+{
+    return generations_.size() - free_indices_.size();
+}
+
+ComponentArray<Transform> &ComponentStore::transforms()
+{
+    return transforms_;
+}
+
+ComponentArray<RigidBody> &ComponentStore::rigid_bodies()
+{
+    return rigid_bodies_;
+}
+
+ComponentArray<RenderEntity> &ComponentStore::render_entities()
+{
+    return render_entities_;
+}
+
+ComponentArray<const AudioClip *> &ComponentStore::audio_emitters()
+{
+    return audio_emitters_;
+}
+
+ComponentArray<std::uint64_t> &ComponentStore::user_data()
+{
+    return user_data_;
+}
+
+}
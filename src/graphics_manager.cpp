@@ -1,27 +1,151 @@
 #include "graphics_manager.h"
 
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <format>
+#include <fstream>
 #include <functional>
+#include <map>
+#include <memory>
+#include <span>
+#include <stdexcept>
 #include <string>
+#include <system_error>
+#include <unordered_set>
+#include <utility>
+#include <vector>
 
 #include "colour.h"
+#include "cube_desc.h"
 #include "degree.h"
+#include "graphics_config.h"
+#include "instancing_technique.h"
+#include "job_system.h"
 #include "manual_object.h"
+#include "mesh_lod_settings.h"
 #include "quaternion.h"
 #include "render_entity.h"
+#include "shadow_config.h"
+#include "task_graph.h"
 #include "vector3.h"
 
 #include "Ogre.h"
 #include "OgreApplicationContext.h"
+#include "OgreDistanceLodStrategy.h"
+#include "OgreInstanceManager.h"
+#include "OgreInstancedEntity.h"
+#include "OgreLodConfig.h"
+#include "OgreMeshLodGenerator.h"
+#include "OgreMeshSerializer.h"
+#include "OgreRTShaderSystem.h"
+#include "OgrePixelCountLodStrategy.h"
+#include "OgreShadowCameraSetupPSSM.h"
+
+namespace
+{
+
+/**
+ * Number of instances drawn by each instance batch, a new batch and draw call is only needed once one fills up.
+ */
+constexpr auto instances_per_batch = 4096u;
+
+/**
+ * Name of Ogre's software render system, used when headless.
+ */
+constexpr auto tiny_render_system_name = "Tiny Rendering Subsystem";
+
+/**
+ * Number of splits used by TEXTURE_PSSM, fixed by the shader generator's PSSM stage.
+ */
+constexpr auto pssm_split_count = 3u;
+
+/**
+ * Distance to split the directional light's shadow maps over when no far distance is set.
+ */
+constexpr auto default_pssm_far_distance = 2000.0f;
+
+/**
+ * Helper function to hash some bytes with FNV-1a.
+ *
+ * @param bytes
+ *   The bytes to hash.
+ *
+ * @param hash
+ *   Hash to continue from, allowing multiple buffers to be hashed together.
+ *
+ * @returns
+ *   Hash of the bytes.
+ */
+std::uint64_t hash_bytes(std::span<const std::byte> bytes, std::uint64_t hash = 0xcbf29ce484222325u)
+{
+    for (const auto byte : bytes)
+    {
+        hash ^= static_cast<std::uint64_t>(byte);
+        hash *= 0x100000001b3u;
+    }
+
+    return hash;
+}
+
+/**
+ * Helper function to get the path of the file a mesh was loaded from.
+ *
+ * @param mesh_name
+ *   Name of the mesh.
+ *
+ * @returns
+ *   Path of the mesh file, or an empty path if the mesh does not live in a directory on disk (e.g. a zip).
+ */
+std::filesystem::path mesh_path_for(const std::string &mesh_name)
+{
+    auto &resource_manager = ::Ogre::ResourceGroupManager::getSingleton();
+
+    const auto &group = resource_manager.findGroupContainingResource(mesh_name);
+    const auto files = resource_manager.findResourceFileInfo(group, mesh_name);
+
+    if (files->empty() || (files->front().archive->getType() != "FileSystem"))
+    {
+        return {};
+    }
+
+    return std::filesystem::path{files->front().archive->getName()} / files->front().filename;
+}
+
+}
 
 namespace bab
 {
 
-GraphicsManager::GraphicsManager()
-    : scene_manager_(nullptr)
-    , frame_start_callbacks_()
+GraphicsManager::GraphicsManager(const GraphicsConfig &config)
+    : config_(config)
+    , scene_manager_(nullptr)
+    , job_system_(config.job_thread_count)
+    , frame_tasks_()
+    , frame_start_callback_count_(0u)
+    , shadow_config_()
+    , pssm_state_(nullptr)
+    , mesh_lod_()
+    , mesh_lod_hash_(0u)
+    , lod_generator_()
+    , static_casters_(nullptr)
+    , static_receivers_(nullptr)
+    , instance_managers_()
+    , instanced_materials_()
     , frame_end_callbacks_()
 {
     initApp();
+
+    // oneTimeConfig() fails without a window if the render system is missing, such as Tiny for headless runs
+    if (getRenderWindow() == nullptr)
+    {
+        closeApp();
+
+        throw std::runtime_error(std::format(
+            "could not create a render window, is {} installed?",
+            config_.headless ? tiny_render_system_name : "a render system"));
+    }
+
     scene_manager_ = getRoot()->createSceneManager();
 
     auto *shader_gen = ::Ogre::RTShader::ShaderGenerator::getSingletonPtr();
@@ -33,7 +157,6 @@ GraphicsManager::GraphicsManager()
 
     // set scene properties
     scene_manager_->setAmbientLight(::Ogre::ColourValue{0.2, 0.2, 0.2});
-    scene_manager_->setShadowTechnique(::Ogre::ShadowTechnique::SHADOWTYPE_STENCIL_ADDITIVE);
 
     // create a camera
     auto *camera = scene_manager_->createCamera("main_camera");
@@ -49,11 +172,16 @@ GraphicsManager::GraphicsManager()
     vp->setBackgroundColour(::Ogre::ColourValue{0.0, 0.0, 0.0});
     camera->setAspectRatio(::Ogre::Real(vp->getActualWidth()) / ::Ogre::Real(vp->getActualHeight()));
 
+    set_shadows(shadow_config_);
+
     addInputListener(this);
 }
 
 GraphicsManager::~GraphicsManager()
 {
+    // the generator is an ogre singleton so must go before ogre shuts down
+    lod_generator_.reset();
+
     closeApp();
 }
 
@@ -63,8 +191,9 @@ void GraphicsManager::add_mesh(
     const Quaternion &orientation,
     bool casts_shadows)
 {
-    auto *entity = scene_manager_->createEntity(mesh_name);
+    auto *entity = scene_manager_->createEntity(load_mesh(mesh_name));
     entity->setCastShadows(casts_shadows);
+    configure_shadow_caster(entity);
 
     auto *node = scene_manager_->getRootSceneNode()->createChildSceneNode();
     node->attachObject(entity);
@@ -80,31 +209,125 @@ void GraphicsManager::add_plane(
     bool casts_shadows,
     const std::string &material_name)
 {
-    static auto plane_counter = 0u;
-    std::string name = "plane" + std::to_string(plane_counter++);
-
-    ::Ogre::Plane plane{::Ogre::Vector3::UNIT_Y, 0.0};
-    ::Ogre::MeshManager::getSingleton().createPlane(
-        name,
-        ::Ogre::RGN_DEFAULT,
-        plane,
-        width,
-        height,
-        static_cast<int>(x_segments),
-        static_cast<int>(z_segments),
-        true,
-        1,
-        5,
-        5.0,
-        ::Ogre::Vector3::UNIT_Z);
+    const auto name = create_plane_mesh(width, height, x_segments, z_segments);
 
     auto *entity = scene_manager_->createEntity(name);
     entity->setCastShadows(casts_shadows);
     entity->setMaterialName(material_name);
+    configure_shadow_caster(entity);
 
     scene_manager_->getRootSceneNode()->createChildSceneNode()->attachObject(entity);
 }
 
+void GraphicsManager::set_shadows(const ShadowConfig &config)
+{
+    shadow_config_ = config;
+
+    auto *shader_gen = ::Ogre::RTShader::ShaderGenerator::getSingletonPtr();
+    auto *render_state = shader_gen->getRenderState(::Ogre::RTShader::ShaderGenerator::DEFAULT_SCHEME_NAME);
+
+    if (pssm_state_ != nullptr)
+    {
+        render_state->removeSubRenderState(pssm_state_);
+        pssm_state_ = nullptr;
+    }
+
+    scene_manager_->setShadowFarDistance(config.far_distance);
+    scene_manager_->setShadowCameraSetup(std::make_shared<::Ogre::DefaultShadowCameraSetup>());
+
+    switch (config.technique)
+    {
+        case ShadowTechnique::NONE:
+            scene_manager_->setShadowTechnique(::Ogre::SHADOWTYPE_NONE);
+            break;
+        case ShadowTechnique::STENCIL_ADDITIVE:
+            scene_manager_->setShadowTechnique(::Ogre::SHADOWTYPE_STENCIL_ADDITIVE);
+            break;
+        case ShadowTechnique::TEXTURE_MODULATIVE:
+            scene_manager_->setShadowTechnique(::Ogre::SHADOWTYPE_TEXTURE_MODULATIVE);
+            scene_manager_->setShadowTextureSettings(config.texture_size, config.texture_count);
+            break;
+        case ShadowTechnique::TEXTURE_PSSM:
+        {
+            scene_manager_->setShadowTechnique(::Ogre::SHADOWTYPE_TEXTURE_ADDITIVE_INTEGRATED);
+            scene_manager_->setShadowTextureCountPerLightType(::Ogre::Light::LT_DIRECTIONAL, pssm_split_count);
+            scene_manager_->setShadowTextureSettings(config.texture_size, pssm_split_count, ::Ogre::PF_DEPTH16);
+            scene_manager_->setShadowTextureSelfShadow(true);
+
+            const auto *camera = scene_manager_->getCamera("main_camera");
+            const auto far_distance = (config.far_distance > 0.0f) ? config.far_distance : default_pssm_far_distance;
+
+            auto pssm = std::make_shared<::Ogre::PSSMShadowCameraSetup>();
+            pssm->calculateSplitPoints(pssm_split_count, camera->getNearClipDistance(), far_distance);
+            pssm->setSplitPadding(camera->getNearClipDistance());
+            scene_manager_->setShadowCameraSetup(pssm);
+
+            // the generated shaders pick a split per pixel, so they must know where the splits are
+            pssm_state_ = shader_gen->createSubRenderState(::Ogre::RTShader::IntegratedPSSM3::Type);
+            static_cast<::Ogre::RTShader::IntegratedPSSM3 *>(pssm_state_)->setSplitPoints(pssm->getSplitPoints());
+            render_state->addTemplateSubRenderState(pssm_state_);
+            break;
+        }
+    }
+
+    shader_gen->invalidateScheme(::Ogre::RTShader::ShaderGenerator::DEFAULT_SCHEME_NAME);
+
+    for (const auto &[_, entity] : scene_manager_->getMovableObjects(::Ogre::EntityFactory::FACTORY_TYPE_NAME))
+    {
+        configure_shadow_caster(entity);
+    }
+}
+
+void GraphicsManager::set_mesh_lod(const MeshLodSettings &settings)
+{
+    mesh_lod_ = settings;
+    mesh_lod_hash_ = hash_bytes(std::as_bytes(std::span{&mesh_lod_.strategy, 1u}));
+    mesh_lod_hash_ = hash_bytes(std::as_bytes(std::span{mesh_lod_.levels}), mesh_lod_hash_);
+
+    if (!mesh_lod_.levels.empty() && !lod_generator_)
+    {
+        lod_generator_ = std::make_unique<::Ogre::MeshLodGenerator>();
+    }
+}
+
+void GraphicsManager::add_static_mesh(
+    const std::string &mesh_name,
+    const Vector3 &position,
+    const Quaternion &orientation,
+    bool casts_shadows)
+{
+    // static geometry copies the mesh data out of the entity, so it is only needed long enough to be added
+    auto *entity = scene_manager_->createEntity(load_mesh(mesh_name));
+    static_geometry(casts_shadows)->addEntity(entity, position, orientation);
+    scene_manager_->destroyEntity(entity);
+}
+
+void GraphicsManager::add_static_plane(
+    float width,
+    float height,
+    std::uint32_t x_segments,
+    std::uint32_t z_segments,
+    bool casts_shadows,
+    const std::string &material_name)
+{
+    auto *entity = scene_manager_->createEntity(create_plane_mesh(width, height, x_segments, z_segments));
+    entity->setMaterialName(material_name);
+    static_geometry(casts_shadows)->addEntity(entity, ::Ogre::Vector3::ZERO);
+    scene_manager_->destroyEntity(entity);
+}
+
+void GraphicsManager::build_static_geometry(const Vector3 &region_size)
+{
+    for (auto *geometry : {static_casters_, static_receivers_})
+    {
+        if (geometry != nullptr)
+        {
+            geometry->setRegionDimensions(region_size);
+            geometry->build();
+        }
+    }
+}
+
 void GraphicsManager::add_material(const std::string &name, const std::string &texture_name)
 {
     const auto material = ::Ogre::MaterialManager::getSingleton().create(name, "bab");
@@ -118,6 +341,7 @@ RenderEntity GraphicsManager::add_cube(const Vector3 &position, float scale, con
 {
     auto *entity = scene_manager_->createEntity("cube.mesh");
     entity->setMaterialName(material_name);
+    configure_shadow_caster(entity);
 
     auto *node = scene_manager_->getRootSceneNode()->createChildSceneNode();
     node->attachObject(entity);
@@ -127,6 +351,82 @@ RenderEntity GraphicsManager::add_cube(const Vector3 &position, float scale, con
     return {node};
 }
 
+std::vector<RenderEntity> GraphicsManager::add_cubes(std::span<const CubeDesc> descs)
+{
+    const auto mesh = ::Ogre::MeshManager::getSingleton().load(
+        "cube.mesh", ::Ogre::ResourceGroupManager::AUTODETECT_RESOURCE_GROUP_NAME);
+    auto *root_node = scene_manager_->getRootSceneNode();
+
+    std::vector<RenderEntity> render_entities{};
+    render_entities.reserve(descs.size());
+
+    // batches are usually built from a handful of materials, so only look a material up when it changes
+    ::Ogre::MaterialPtr material{};
+
+    for (const auto &desc : descs)
+    {
+        if (!material || (material->getName() != desc.material_name))
+        {
+            material = ::Ogre::MaterialManager::getSingleton().getByName(desc.material_name);
+        }
+
+        auto *entity = scene_manager_->createEntity(mesh);
+        entity->setMaterial(material);
+        configure_shadow_caster(entity);
+
+        auto *node = root_node->createChildSceneNode(desc.position);
+        node->attachObject(entity);
+        node->setScale(desc.scale, desc.scale, desc.scale);
+
+        render_entities.push_back({node});
+    }
+
+    return render_entities;
+}
+
+RenderEntity GraphicsManager::add_instanced_cube(
+    const Vector3 &position,
+    float scale,
+    const std::string &material_name,
+    InstancingTechnique technique)
+{
+    const CubeDesc desc{position, scale, material_name, 0.0f};
+    return add_instanced_cubes({&desc, 1u}, technique).front();
+}
+
+std::vector<RenderEntity> GraphicsManager::add_instanced_cubes(
+    std::span<const CubeDesc> descs,
+    InstancingTechnique technique)
+{
+    const auto &manager_name = instance_manager("cube.mesh", technique)->getName();
+
+    std::vector<RenderEntity> render_entities{};
+    render_entities.reserve(descs.size());
+
+    const std::string *last_material = nullptr;
+    std::string instance_material{};
+
+    for (const auto &desc : descs)
+    {
+        if ((last_material == nullptr) || (*last_material != desc.material_name))
+        {
+            instance_material = (technique == InstancingTechnique::HARDWARE_BASIC)
+                                    ? enable_instancing(desc.material_name)
+                                    : desc.material_name;
+            last_material = &desc.material_name;
+        }
+
+        auto *instance = scene_manager_->createInstancedEntity(instance_material, manager_name);
+        instance->setPosition(desc.position, false);
+        instance->setScale({desc.scale, desc.scale, desc.scale});
+        configure_shadow_caster(instance);
+
+        render_entities.push_back({instance});
+    }
+
+    return render_entities;
+}
+
 ManualObject GraphicsManager::add_manual_object()
 {
     static auto counter = 0u;
@@ -213,28 +513,295 @@ void GraphicsManager::set_sky_dome(const std::string &material_name, float curva
     scene_manager_->setSkyDome(true, material_name, curvature, tiling);
 }
 
-void GraphicsManager::register_frame_start_callback(std::function<void()> callback)
+void GraphicsManager::add_frame_task(
+    const std::string &name,
+    const std::vector<std::string> &dependencies,
+    std::function<void(float)> task,
+    bool main_thread)
 {
-    frame_start_callbacks_.push_back(std::move(callback));
+    frame_tasks_.add_task(name, dependencies, std::move(task), main_thread);
 }
 
-void GraphicsManager::register_frame_end_callback(std::function<void()> callback)
+void GraphicsManager::register_frame_start_callback(std::function<void(float)> callback)
+{
+    // chain each callback after the previous one so they keep running in registration order
+    std::vector<std::string> dependencies{};
+    if (frame_start_callback_count_ != 0u)
+    {
+        dependencies.push_back("frame_start_callback_" + std::to_string(frame_start_callback_count_ - 1u));
+    }
+
+    frame_tasks_.add_task(
+        "frame_start_callback_" + std::to_string(frame_start_callback_count_++),
+        dependencies,
+        std::move(callback),
+        true);
+}
+
+void GraphicsManager::register_frame_end_callback(std::function<void(float)> callback)
 {
     frame_end_callbacks_.push_back(std::move(callback));
 }
 
+std::size_t GraphicsManager::draw_call_count() const
+{
+    return getRenderWindow()->getStatistics().batchCount;
+}
+
+JobSystem &GraphicsManager::job_system()
+{
+    return job_system_;
+}
+
 void GraphicsManager::start_rendering()
 {
     getRoot()->startRendering();
 }
 
-bool GraphicsManager::frameStarted(const ::Ogre::FrameEvent &evt)
+void GraphicsManager::configure_shadow_caster(::Ogre::MovableObject *object) const
+{
+    // a rendering distance of zero means the shadow is always rendered
+    object->setShadowRenderingDistance(shadow_config_.caster_distance);
+}
+
+::Ogre::MeshPtr GraphicsManager::load_mesh(const std::string &mesh_name)
 {
-    for (const auto &callback : frame_start_callbacks_)
+    auto &mesh_manager = ::Ogre::MeshManager::getSingleton();
+
+    if (mesh_lod_.levels.empty())
+    {
+        return mesh_manager.load(mesh_name, ::Ogre::ResourceGroupManager::AUTODETECT_RESOURCE_GROUP_NAME);
+    }
+
+    // the generated mesh is named after the settings, so meshes can be shared between calls with the same settings
+    const auto lod_name = std::format("{}.{:016x}.lod", mesh_name, mesh_lod_hash_);
+    if (auto mesh = mesh_manager.getByName(lod_name, "bab"); mesh)
+    {
+        return mesh;
+    }
+
+    // cache files sit next to the mesh and are only used if they are newer, so edited meshes are regenerated
+    const auto mesh_path = mesh_path_for(mesh_name);
+    auto cache_path = mesh_path;
+    if (!cache_path.empty())
     {
-        callback();
+        cache_path += std::format(".{:016x}.lod", mesh_lod_hash_);
     }
 
+    if (!cache_path.empty() && std::filesystem::exists(cache_path) &&
+        (std::filesystem::last_write_time(cache_path) >= std::filesystem::last_write_time(mesh_path)))
+    {
+        std::ifstream file{cache_path, std::ios::binary};
+        const auto stream = std::make_shared<::Ogre::FileStreamDataStream>(&file, false);
+
+        auto mesh = mesh_manager.createManual(lod_name, "bab");
+        ::Ogre::MeshSerializer{}.importMesh(stream, mesh.get());
+
+        return mesh;
+    }
+
+    auto mesh = mesh_manager.load(mesh_name, ::Ogre::ResourceGroupManager::AUTODETECT_RESOURCE_GROUP_NAME)
+                    ->clone(lod_name, "bab");
+
+    auto *strategy = (mesh_lod_.strategy == MeshLodStrategy::DISTANCE)
+                         ? static_cast<::Ogre::LodStrategy *>(::Ogre::DistanceLodBoxStrategy::getSingletonPtr())
+                         : ::Ogre::AbsolutePixelCountLodStrategy::getSingletonPtr();
+
+    ::Ogre::LodConfig config{mesh, strategy};
+    for (const auto &level : mesh_lod_.levels)
+    {
+        config.createGeneratedLodLevel(level.value, level.reduction, ::Ogre::LodLevel::VRM_PROPORTIONAL);
+    }
+
+    lod_generator_->generateLodLevels(config);
+
+    if (!cache_path.empty())
+    {
+        // the cache is only an optimisation, so a read only or full disk just means regenerating next time
+        try
+        {
+            ::Ogre::MeshSerializer{}.exportMesh(mesh, cache_path.string());
+        }
+        catch (const ::Ogre::Exception &exception)
+        {
+            ::Ogre::LogManager::getSingleton().logWarning(
+                std::format("could not cache lod mesh {}: {}", cache_path.string(), exception.getDescription()));
+
+            // don't leave a partial file behind for the next run to load
+            std::error_code error{};
+            std::filesystem::remove(cache_path, error);
+        }
+    }
+
+    return mesh;
+}
+
+std::string GraphicsManager::create_plane_mesh(
+    float width,
+    float height,
+    std::uint32_t x_segments,
+    std::uint32_t z_segments)
+{
+    static auto plane_counter = 0u;
+    std::string name = "plane" + std::to_string(plane_counter++);
+
+    ::Ogre::Plane plane{::Ogre::Vector3::UNIT_Y, 0.0};
+    ::Ogre::MeshManager::getSingleton().createPlane(
+        name,
+        ::Ogre::RGN_DEFAULT,
+        plane,
+        width,
+        height,
+        static_cast<int>(x_segments),
+        static_cast<int>(z_segments),
+        true,
+        1,
+        5,
+        5.0,
+        ::Ogre::Vector3::UNIT_Z);
+
+    return name;
+}
+
+::Ogre::StaticGeometry *GraphicsManager::static_geometry(bool casts_shadows)
+{
+    auto *&geometry = casts_shadows ? static_casters_ : static_receivers_;
+
+    if (geometry == nullptr)
+    {
+        geometry = scene_manager_->createStaticGeometry(casts_shadows ? "static_casters" : "static_receivers");
+        geometry->setCastShadows(casts_shadows);
+    }
+
+    return geometry;
+}
+
+::Ogre::InstanceManager *GraphicsManager::instance_manager(
+    const std::string &mesh_name,
+    InstancingTechnique technique)
+{
+    const auto key = std::make_pair(mesh_name, technique);
+
+    if (const auto manager = instance_managers_.find(key); manager != std::cend(instance_managers_))
+    {
+        return manager->second;
+    }
+
+    const auto ogre_technique = (technique == InstancingTechnique::HARDWARE_BASIC)
+                                    ? ::Ogre::InstanceManager::HWInstancingBasic
+                                    : ::Ogre::InstanceManager::HWInstancingVTF;
+
+    auto *manager = scene_manager_->createInstanceManager(
+        "instance_manager" + std::to_string(instance_managers_.size()),
+        mesh_name,
+        ::Ogre::ResourceGroupManager::AUTODETECT_RESOURCE_GROUP_NAME,
+        ogre_technique,
+        instances_per_batch);
+
+    instance_managers_.emplace(key, manager);
+
+    return manager;
+}
+
+std::string GraphicsManager::enable_instancing(const std::string &material_name)
+{
+    auto instanced_name = material_name + "/Instanced";
+
+    if (instanced_materials_.contains(material_name))
+    {
+        return instanced_name;
+    }
+
+    const auto source = ::Ogre::MaterialManager::getSingleton().getByName(material_name);
+    if (!source)
+    {
+        throw std::runtime_error(std::format("unknown material {}", material_name));
+    }
+
+    // basic hardware instancing reads each world matrix from per-instance texture coordinates, so the generated vertex
+    // shader needs the instanced variant of the transform stage, which would break the material for normal entities
+    const auto material = source->clone(instanced_name);
+    const auto &scheme = ::Ogre::RTShader::ShaderGenerator::DEFAULT_SCHEME_NAME;
+
+    auto *shader_gen = ::Ogre::RTShader::ShaderGenerator::getSingletonPtr();
+    shader_gen->createShaderBasedTechnique(*material, ::Ogre::MaterialManager::DEFAULT_SCHEME_NAME, scheme);
+
+    auto *transform = shader_gen->createSubRenderState("FFP_Transform");
+    transform->setParameter("instanced", "true");
+    shader_gen->getRenderState(scheme, *material)->addTemplateSubRenderState(transform);
+
+    shader_gen->validateMaterial(scheme, *material);
+
+    instanced_materials_.insert(material_name);
+
+    return instanced_name;
+}
+
+bool GraphicsManager::render_frame()
+{
+    return getRoot()->renderOneFrame();
+}
+
+std::vector<std::byte> GraphicsManager::capture_frame() const
+{
+    const auto width = frame_width();
+    const auto height = frame_height();
+
+    std::vector<std::byte> pixels(static_cast<std::size_t>(width) * height * 4u);
+
+    const ::Ogre::PixelBox box{width, height, 1u, ::Ogre::PF_BYTE_RGBA, pixels.data()};
+    getRenderWindow()->copyContentsToMemory(box, box);
+
+    return pixels;
+}
+
+std::uint32_t GraphicsManager::frame_width() const
+{
+    return getRenderWindow()->getWidth();
+}
+
+std::uint32_t GraphicsManager::frame_height() const
+{
+    return getRenderWindow()->getHeight();
+}
+
+bool GraphicsManager::oneTimeConfig()
+{
+    if (!config_.headless)
+    {
+        return ::OgreBites::ApplicationContext::oneTimeConfig();
+    }
+
+    auto *render_system = getRoot()->getRenderSystemByName(tiny_render_system_name);
+    if (render_system == nullptr)
+    {
+        return false;
+    }
+
+    getRoot()->setRenderSystem(render_system);
+
+    return true;
+}
+
+::OgreBites::NativeWindowPair GraphicsManager::createWindow(
+    const ::Ogre::String &name,
+    std::uint32_t width,
+    std::uint32_t height,
+    ::Ogre::NameValuePairList misc_params)
+{
+    if (!config_.headless)
+    {
+        return ::OgreBites::ApplicationContext::createWindow(name, width, height, misc_params);
+    }
+
+    // skip the SDL window entirely, the software render system's window is just a buffer in memory
+    return ::OgreBites::ApplicationContextBase::createWindow(name, config_.width, config_.height, misc_params);
+}
+
+bool GraphicsManager::frameStarted(const ::Ogre::FrameEvent &evt)
+{
+    frame_tasks_.run(evt.timeSinceLastFrame, job_system_);
+
     return ::OgreBites::ApplicationContext::frameStarted(evt);
 }
 
@@ -242,7 +809,7 @@ bool GraphicsManager::frameEnded(const ::Ogre::FrameEvent &evt)
 {
     for (const auto &callback : frame_end_callbacks_)
     {
-        callback();
+        callback(evt.timeSinceLastFrame);
     }
 
     return ::OgreBites::ApplicationContext::frameEnded(evt);
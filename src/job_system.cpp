@@ -0,0 +1,157 @@
+#include "job_system.h"
+
+#include <atomic>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <stop_token>
+#include <thread>
+#include <utility>
+#include <vector>
+
+namespace
+{
+
+/** The JobSystem the calling thread is a worker of, if any. */
+thread_local const bab::JobSystem *current_system = nullptr;
+
+/** Index of the calling thread's queue in current_system. */
+thread_local auto current_queue = 0u;
+
+}
+
+namespace bab
+{
+
+JobSystem::JobSystem(std::uint32_t thread_count)
+    : queues_()
+    , queued_(0u)
+    , sleep_mutex_()
+    , work_available_()
+    , workers_()
+{
+    // the shared queue for threads outside the pool, then one per worker
+    queues_.push_back(std::make_unique<Queue>());
+    for (auto i = 1u; i < thread_count; ++i)
+    {
+        queues_.push_back(std::make_unique<Queue>());
+    }
+
+    for (auto i = 1u; i < thread_count; ++i)
+    {
+        workers_.emplace_back([this, i](std::stop_token stop_token) { worker_loop(stop_token, i); });
+    }
+}
+
+JobSystem::~JobSystem()
+{
+    for (auto &worker : workers_)
+    {
+        worker.request_stop();
+    }
+
+    // jthread destructor joins
+    workers_.clear();
+}
+
+std::uint32_t JobSystem::thread_count() const
+{
+    return static_cast<std::uint32_t>(workers_.size()) + 1u;
+}
+
+void JobSystem::submit(std::function<void()> job)
+{
+    auto &queue = *queues_[queue_index()];
+
+    {
+        std::scoped_lock lock{queue.mutex};
+        queue.jobs.push_back(std::move(job));
+    }
+
+    {
+        std::scoped_lock lock{sleep_mutex_};
+        ++queued_;
+    }
+
+    work_available_.notify_one();
+}
+
+bool JobSystem::run_one()
+{
+    auto job = take(queue_index());
+    if (!job)
+    {
+        return false;
+    }
+
+    (*job)();
+    return true;
+}
+
+void JobSystem::worker_loop(std::stop_token stop_token, std::uint32_t queue_index)
+{
+    current_system = this;
+    current_queue = queue_index;
+
+    for (;;)
+    {
+        if (auto job = take(queue_index); job)
+        {
+            (*job)();
+            continue;
+        }
+
+        std::unique_lock lock{sleep_mutex_};
+        if (!work_available_.wait(lock, stop_token, [this] { return queued_ != 0u; }))
+        {
+            // stop was requested
+            return;
+        }
+    }
+}
+
+std::optional<std::function<void()>> JobSystem::take(std::uint32_t queue_index)
+{
+    // newest job first from our own queue, its data is the most likely to still be in cache
+    {
+        auto &queue = *queues_[queue_index];
+        std::scoped_lock lock{queue.mutex};
+
+        if (!queue.jobs.empty())
+        {
+            auto job = std::move(queue.jobs.back());
+            queue.jobs.pop_back();
+            --queued_;
+
+            return job;
+        }
+    }
+
+    // steal the oldest job from the next queue that has one, starting after our own so thieves spread out
+    const auto queue_count = static_cast<std::uint32_t>(queues_.size());
+    for (auto offset = 1u; offset < queue_count; ++offset)
+    {
+        auto &queue = *queues_[(queue_index + offset) % queue_count];
+        std::scoped_lock lock{queue.mutex};
+
+        if (!queue.jobs.empty())
+        {
+            auto job = std::move(queue.jobs.front());
+            queue.jobs.pop_front();
+            --queued_;
+
+            return job;
+        }
+    }
+
+    return std::nullopt;
+}
+
+std::uint32_t JobSystem::queue_index() const
+{
+    return (current_system == this) ? current_queue : 0u;
+}
+
+}
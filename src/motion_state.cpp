@@ -0,0 +1,96 @@
+#include "motion_state.h"
+
+#include <cstdint>
+#include <vector>
+
+#include "LinearMath/btMotionState.h"
+#include "LinearMath/btQuaternion.h"
+#include "LinearMath/btTransform.h"
+#include "LinearMath/btVector3.h"
+
+namespace bab
+{
+
+MotionState::MotionState(
+    const ::btTransform &start_transform,
+    const std::uint64_t &tick,
+    std::uint32_t index,
+    std::vector<std::uint32_t> &dirty_list)
+    : previous_(start_transform)
+    , current_(start_transform)
+    , previous_rotation_(start_transform.getRotation())
+    , current_rotation_(previous_rotation_)
+    , tick_(tick)
+    , updated_tick_(tick)
+    , index_(index)
+    , dirty_list_(dirty_list)
+    , dirty_(false)
+{
+}
+
+void MotionState::getWorldTransform(::btTransform &world_transform) const
+{
+    world_transform = current_;
+}
+
+void MotionState::setWorldTransform(const ::btTransform &world_transform)
+{
+    previous_ = current_;
+    current_ = world_transform;
+    previous_rotation_ = current_rotation_;
+    current_rotation_ = world_transform.getRotation();
+    updated_tick_ = tick_;
+
+    // bullet synchronises motion states serially after each step, so this is never called concurrently
+    if (!dirty_)
+    {
+        dirty_ = true;
+        dirty_list_.push_back(index_);
+    }
+}
+
+void MotionState::reset(const ::btTransform &world_transform)
+{
+    setWorldTransform(world_transform);
+
+    previous_ = current_;
+    previous_rotation_ = current_rotation_;
+}
+
+::btVector3 MotionState::interpolated_origin(float alpha) const
+{
+    // bullet does not update sleeping bodies, so if we missed the last tick we are at rest and should not interpolate
+    if (updated_tick_ != tick_)
+    {
+        return current_.getOrigin();
+    }
+
+    return previous_.getOrigin().lerp(current_.getOrigin(), alpha);
+}
+
+::btQuaternion MotionState::interpolated_rotation(float alpha) const
+{
+    if (updated_tick_ != tick_)
+    {
+        return current_rotation_;
+    }
+
+    return previous_rotation_.slerp(current_rotation_, alpha);
+}
+
+std::uint64_t MotionState::updated_tick() const
+{
+    return updated_tick_;
+}
+
+bool MotionState::is_dirty() const
+{
+    return dirty_;
+}
+
+void MotionState::mark_clean()
+{
+    dirty_ = false;
+}
+
+}
@@ -0,0 +1,35 @@
+#include "overlap_filter.h"
+
+#include "BulletCollision/BroadphaseCollision/btBroadphaseProxy.h"
+#include "BulletCollision/BroadphaseCollision/btOverlappingPairCache.h"
+#include "BulletCollision/CollisionDispatch/btCollisionObject.h"
+#include "BulletCollision/CollisionDispatch/btGhostObject.h"
+
+namespace bab
+{
+
+bool OverlapFilter::needBroadphaseCollision(::btBroadphaseProxy *proxy0, ::btBroadphaseProxy *proxy1) const
+{
+    // the same test bullet does by default, each object must be in a layer the other collides with
+    if (((proxy0->m_collisionFilterGroup & proxy1->m_collisionFilterMask) == 0) ||
+        ((proxy1->m_collisionFilterGroup & proxy0->m_collisionFilterMask) == 0))
+    {
+        return false;
+    }
+
+    const auto *object0 = static_cast<const ::btCollisionObject *>(proxy0->m_clientObject);
+    const auto *object1 = static_cast<const ::btCollisionObject *>(proxy1->m_clientObject);
+
+    const auto *ghost0 = ::btGhostObject::upcast(object0);
+    const auto *ghost1 = ::btGhostObject::upcast(object1);
+
+    if ((ghost0 != nullptr) || (ghost1 != nullptr))
+    {
+        const auto *other = (ghost0 != nullptr) ? object1 : object0;
+        return (::btGhostObject::upcast(other) == nullptr) && !other->isStaticObject();
+    }
+
+    return !(object0->isStaticOrKinematicObject() && object1->isStaticOrKinematicObject());
+}
+
+}
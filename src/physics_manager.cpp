@@ -1,21 +1,68 @@
 #include "physics_manager.h"
 
+#include <algorithm>
+#include <cassert>
+#include <chrono>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <format>
 #include <functional>
+#include <limits>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <span>
+#include <stdexcept>
+#include <stop_token>
+#include <string>
+#include <thread>
+#include <type_traits>
 #include <unordered_map>
+#include <utility>
 #include <vector>
 
+#include "box_plane_collision_configuration.h"
+#include "box_rigid_body_desc.h"
+#include "collision_event.h"
+#include "collision_layers.h"
 #include "debug_drawer.h"
+#include "motion_state.h"
+#include "overlap_filter.h"
+#include "physics_config.h"
+#include "physics_query.h"
+#include "quaternion.h"
 #include "rigid_body.h"
+#include "rigid_body_pool.h"
+#include "shape_cache.h"
+#include "task_scheduler.h"
+#include "thread_pool.h"
+#include "transform.h"
+#include "transform_snapshot.h"
+#include "trigger_event.h"
+#include "trigger_volume.h"
 #include "vector3.h"
 
+#include "BulletCollision/BroadphaseCollision/btAxisSweep3.h"
+#include "BulletCollision/BroadphaseCollision/btBroadphaseInterface.h"
+#include "BulletCollision/BroadphaseCollision/btBroadphaseProxy.h"
+#include "BulletCollision/BroadphaseCollision/btDbvt.h"
 #include "BulletCollision/BroadphaseCollision/btDbvtBroadphase.h"
 #include "BulletCollision/CollisionDispatch/btCollisionDispatcher.h"
+#include "BulletCollision/CollisionDispatch/btCollisionDispatcherMt.h"
+#include "BulletCollision/CollisionDispatch/btCollisionWorld.h"
 #include "BulletCollision/CollisionDispatch/btDefaultCollisionConfiguration.h"
 #include "BulletCollision/CollisionDispatch/btGhostObject.h"
 #include "BulletCollision/CollisionShapes/btBoxShape.h"
+#include "BulletCollision/NarrowPhaseCollision/btPersistentManifold.h"
 #include "BulletDynamics/ConstraintSolver/btSequentialImpulseConstraintSolver.h"
 #include "BulletDynamics/Dynamics/btDiscreteDynamicsWorld.h"
-#include "LinearMath/btDefaultMotionState.h"
+#include "BulletDynamics/Dynamics/btDiscreteDynamicsWorldMt.h"
+#include "LinearMath/btAabbUtil2.h"
+#include "LinearMath/btIDebugDraw.h"
+#include "LinearMath/btThreads.h"
+#include "LinearMath/btTransform.h"
 
 namespace
 {
@@ -34,122 +81,2284 @@ namespace
     return {vector.x, vector.y, vector.z};
 }
 
+/**
+ * Helper function to convert an engine quaternion to a bullet quaternion.
+ *
+ * @param quaternion
+ *   Engine quaternion to convert.
+ *
+ * @returns
+ *   Supplied engine quaternion as a bullet quaternion.
+ */
+::btQuaternion to_bullet(const bab::Quaternion &quaternion)
+{
+    return {quaternion.x, quaternion.y, quaternion.z, quaternion.w};
+}
+
+/**
+ * Helper function to convert a bullet vector to an engine vector.
+ *
+ * @param vector
+ *   Bullet vector to convert.
+ *
+ * @returns
+ *   Supplied bullet vector as an engine vector.
+ */
+bab::Vector3 to_engine(const ::btVector3 &vector)
+{
+    return {vector.getX(), vector.getY(), vector.getZ()};
+}
+
+/**
+ * Helper function to convert a bullet quaternion to an engine quaternion.
+ *
+ * @param quaternion
+ *   Bullet quaternion to convert.
+ *
+ * @returns
+ *   Supplied bullet quaternion as an engine quaternion.
+ */
+bab::Quaternion to_engine(const ::btQuaternion &quaternion)
+{
+    return {quaternion.getW(), quaternion.getX(), quaternion.getY(), quaternion.getZ()};
+}
+
+/**
+ * Helper function to order two contact pairs by the addresses of their objects.
+ *
+ * @returns
+ *   True if a should be ordered before b.
+ */
+template <class T>
+bool contact_pair_less(const T &a, const T &b)
+{
+    return std::pair{a.object_a, a.object_b} < std::pair{b.object_a, b.object_b};
+}
+
+/**
+ * Header at the start of a world snapshot.
+ */
+struct SnapshotHeader
+{
+    /** Tick the snapshot was taken after. */
+    std::uint64_t tick;
+
+    /** Number of BodySnapshot records following the header. */
+    std::uint32_t body_count;
+
+    /** Number of ManifoldSnapshot records following the bodies. */
+    std::uint32_t manifold_count;
+
+    /** Number of ContactSnapshot records following the manifolds. */
+    std::uint32_t contact_count;
+};
+
+/**
+ * State of a moving rigid body in a world snapshot.
+ */
+struct BodySnapshot
+{
+    /** World transform. */
+    ::btTransformFloatData transform;
+
+    /** Linear velocity. */
+    ::btVector3FloatData linear_velocity;
+
+    /** Angular velocity. */
+    ::btVector3FloatData angular_velocity;
+
+    /** Index of the rigid body. */
+    std::uint32_t index;
+
+    /** Generation of the rigid body, so a new body in the same slot is not restored. */
+    std::uint32_t generation;
+
+    /** Bullet activation state. */
+    std::int32_t activation_state;
+
+    /** How long the body has been still enough to sleep. */
+    float deactivation_time;
+};
+
+/**
+ * A persistent manifold in a world snapshot, ordered by rigid body indices so restore can binary search them.
+ */
+struct ManifoldSnapshot
+{
+    /** Index of the manifold's first rigid body. */
+    std::uint32_t index_a;
+
+    /** Generation of the manifold's first rigid body. */
+    std::uint32_t generation_a;
+
+    /** Index of the manifold's second rigid body. */
+    std::uint32_t index_b;
+
+    /** Generation of the manifold's second rigid body. */
+    std::uint32_t generation_b;
+
+    /** Index of the manifold's first ContactSnapshot. */
+    std::uint32_t first_contact;
+
+    /** Number of contacts in the manifold. */
+    std::uint32_t contact_count;
+};
+
+/**
+ * A contact point in a world snapshot, the parts of btManifoldPoint the solver needs to warm start.
+ */
+struct ContactSnapshot
+{
+    ::btVector3FloatData local_point_a;
+    ::btVector3FloatData local_point_b;
+    ::btVector3FloatData position_world_on_a;
+    ::btVector3FloatData position_world_on_b;
+    ::btVector3FloatData normal_world_on_b;
+    ::btVector3FloatData lateral_friction_dir_1;
+    ::btVector3FloatData lateral_friction_dir_2;
+    float distance;
+    float combined_friction;
+    float combined_rolling_friction;
+    float combined_spinning_friction;
+    float combined_restitution;
+    float applied_impulse;
+    float applied_impulse_lateral_1;
+    float applied_impulse_lateral_2;
+    std::int32_t part_id_0;
+    std::int32_t part_id_1;
+    std::int32_t index_0;
+    std::int32_t index_1;
+    std::int32_t contact_point_flags;
+    std::int32_t life_time;
+};
+
+/**
+ * Helper function to get the byte offset of a record in a world snapshot.
+ *
+ * @param first_record
+ *   Byte offset of the first record of the section.
+ *
+ * @param record_size
+ *   Size of a record in the section.
+ *
+ * @param index
+ *   Index of the record.
+ *
+ * @returns
+ *   Byte offset of the record.
+ */
+constexpr std::size_t record_offset(std::size_t first_record, std::size_t record_size, std::size_t index)
+{
+    return first_record + record_size * index;
+}
+
+/**
+ * Helper function to check a record lies entirely inside a buffer.
+ *
+ * @param buffer_size
+ *   Size of the buffer in bytes.
+ *
+ * @param offset
+ *   Byte offset of the record.
+ *
+ * @param record_size
+ *   Size of the record in bytes.
+ *
+ * @returns
+ *   True if the record fits, otherwise false.
+ */
+constexpr bool record_fits(std::size_t buffer_size, std::size_t offset, std::size_t record_size)
+{
+    return (offset <= buffer_size) && (record_size <= (buffer_size - offset));
+}
+
+/**
+ * Helper function to copy a record out of a buffer, the buffer has no alignment guarantees so records are never
+ * accessed in place.
+ *
+ * @param buffer
+ *   Buffer to read from.
+ *
+ * @param offset
+ *   Byte offset of the record.
+ *
+ * @returns
+ *   Copy of the record, or an empty optional if it runs past the end of the buffer.
+ */
+template <class T>
+std::optional<T> read_record(std::span<const std::byte> buffer, std::size_t offset)
+{
+    static_assert(std::is_trivially_copyable_v<T>);
+
+    if (!record_fits(buffer.size(), offset, sizeof(T)))
+    {
+        return std::nullopt;
+    }
+
+    T record{};
+    std::memcpy(&record, buffer.data() + offset, sizeof(T));
+    return record;
+}
+
+/**
+ * Helper function to copy a record into a buffer.
+ *
+ * @param buffer
+ *   Buffer to write to.
+ *
+ * @param offset
+ *   Byte offset of the record.
+ *
+ * @param record
+ *   The record to write.
+ *
+ * @returns
+ *   True if the record was written, false if it would run past the end of the buffer.
+ */
+template <class T>
+bool write_record(std::span<std::byte> buffer, std::size_t offset, const T &record)
+{
+    static_assert(std::is_trivially_copyable_v<T>);
+
+    if (!record_fits(buffer.size(), offset, sizeof(T)))
+    {
+        return false;
+    }
+
+    std::memcpy(buffer.data() + offset, &record, sizeof(T));
+    return true;
+}
+
+/**
+ * Helper function to copy a bullet vector into snapshot form.
+ *
+ * @param vector
+ *   Bullet vector to convert.
+ *
+ * @returns
+ *   Serialised vector.
+ */
+::btVector3FloatData to_snapshot(const ::btVector3 &vector)
+{
+    ::btVector3FloatData data{};
+    vector.serializeFloat(data);
+    return data;
+}
+
+/**
+ * Helper function to copy a snapshot vector back into a bullet vector.
+ *
+ * @param data
+ *   Serialised vector.
+ *
+ * @returns
+ *   Bullet vector.
+ */
+::btVector3 from_snapshot(const ::btVector3FloatData &data)
+{
+    ::btVector3 vector{};
+    vector.deSerializeFloat(data);
+    return vector;
+}
+
+/**
+ * Helper function to check if a collision object found by a query should be tested, queries only hit rigid bodies which
+ * take part in collisions.
+ *
+ * @param object
+ *   The collision object to check.
+ *
+ * @returns
+ *   True if the object should be tested, otherwise false.
+ */
+bool is_queryable(const ::btCollisionObject *object)
+{
+    return (::btRigidBody::upcast(object) != nullptr) && object->hasContactResponse();
+}
+
+/**
+ * Walk a dbvt and visit every leaf whose bounds, grown by some extents, are crossed by a segment. Leaves are visited in
+ * no particular order, the visitor returns the fraction of the closest hit so far so that nodes beyond it are skipped.
+ *
+ * @param tree
+ *   The tree to walk.
+ *
+ * @param from
+ *   World position the segment starts at.
+ *
+ * @param to
+ *   World position the segment ends at.
+ *
+ * @param extents
+ *   Amount to grow node bounds by on each axis, zero for rays and the half extents of the shape for sweeps.
+ *
+ * @param stack
+ *   Scratch storage for the walk, reused between calls to avoid allocating.
+ *
+ * @param visit
+ *   Function to call with the collision object of each leaf, must return the fraction of the closest hit so far.
+ */
+template <class T>
+void walk_tree(
+    const ::btDbvt &tree,
+    const ::btVector3 &from,
+    const ::btVector3 &to,
+    const ::btVector3 &extents,
+    std::vector<const ::btDbvtNode *> &stack,
+    T &&visit)
+{
+    if (tree.m_root == nullptr)
+    {
+        return;
+    }
+
+    // the direction is not normalised so that distances along it are in the same [0, 1] range as hit fractions, axis
+    // aligned components get a huge reciprocal rather than a divide by zero (the same trick bullet uses)
+    const auto direction = to - from;
+    const ::btVector3 inverse_direction{
+        direction.getX() == 0.0f ? BT_LARGE_FLOAT : 1.0f / direction.getX(),
+        direction.getY() == 0.0f ? BT_LARGE_FLOAT : 1.0f / direction.getY(),
+        direction.getZ() == 0.0f ? BT_LARGE_FLOAT : 1.0f / direction.getZ()};
+    const unsigned int signs[] = {
+        inverse_direction.getX() < 0.0f, inverse_direction.getY() < 0.0f, inverse_direction.getZ() < 0.0f};
+
+    auto max_fraction = ::btScalar{1.0f};
+
+    stack.clear();
+    stack.push_back(tree.m_root);
+
+    while (!stack.empty())
+    {
+        const auto *node = stack.back();
+        stack.pop_back();
+
+        const ::btVector3 bounds[] = {node->volume.Mins() - extents, node->volume.Maxs() + extents};
+        auto entry = ::btScalar{0.0f};
+
+        if (!::btRayAabb2(from, inverse_direction, signs, bounds, entry, 0.0f, max_fraction))
+        {
+            continue;
+        }
+
+        if (node->isinternal())
+        {
+            stack.push_back(node->childs[0]);
+            stack.push_back(node->childs[1]);
+        }
+        else
+        {
+            const auto *proxy = static_cast<const ::btBroadphaseProxy *>(node->data);
+            max_fraction = visit(static_cast<::btCollisionObject *>(proxy->m_clientObject));
+        }
+    }
+}
+
+/**
+ * Adapter to pass a query visitor to a broadphase's callback based ray test.
+ */
+template <class T>
+struct QueryRayCallback : ::btBroadphaseRayCallback
+{
+    /**
+     * Construct a new QueryRayCallback.
+     *
+     * @param visit
+     *   Function to call with the collision object of each proxy.
+     *
+     * @param length
+     *   Length of the ray, to convert hit fractions to distances along it.
+     */
+    QueryRayCallback(T &visit, ::btScalar length)
+        : visit(visit)
+        , length(length)
+    {
+    }
+
+    /**
+     * Called by the broadphase for each proxy the ray may hit.
+     *
+     * @param proxy
+     *   The proxy to test.
+     *
+     * @returns
+     *   True to keep going.
+     */
+    bool process(const ::btBroadphaseProxy *proxy) override
+    {
+        m_lambda_max = visit(static_cast<::btCollisionObject *>(proxy->m_clientObject)) * length;
+        return true;
+    }
+
+    /** Function to call with the collision object of each proxy. */
+    T &visit;
+
+    /** Length of the ray. */
+    ::btScalar length;
+};
+
+/**
+ * Scratch stack for walking the broadphase, one per thread so batches can be split across the thread pool without
+ * allocating once warmed up.
+ */
+thread_local std::vector<const ::btDbvtNode *> query_stack;
+
+/**
+ * Visit every collision object in the broadphase whose bounds, grown by some extents, are crossed by a segment. A dbvt
+ * is walked directly, other broadphases go through their ray test.
+ *
+ * @param dbvt_broadphase
+ *   The broadphase if it is a dbvt, otherwise null.
+ *
+ * @param broadphase
+ *   The broadphase.
+ *
+ * @param from
+ *   World position the segment starts at.
+ *
+ * @param to
+ *   World position the segment ends at.
+ *
+ * @param extents
+ *   Amount to grow bounds by on each axis.
+ *
+ * @param visit
+ *   Function to call with each collision object, must return the fraction of the closest hit so far.
+ */
+template <class T>
+void walk_broadphase(
+    const ::btDbvtBroadphase *dbvt_broadphase,
+    ::btBroadphaseInterface &broadphase,
+    const ::btVector3 &from,
+    const ::btVector3 &to,
+    const ::btVector3 &extents,
+    T &visit)
+{
+    if (dbvt_broadphase != nullptr)
+    {
+        // dynamic and static proxies are kept in separate trees
+        for (const auto &tree : dbvt_broadphase->m_sets)
+        {
+            walk_tree(tree, from, to, extents, query_stack, visit);
+        }
+
+        return;
+    }
+
+    // bullet's ray tests expect a normalised direction with distances measured along it
+    const auto length = (to - from).length();
+    if (length == 0.0f)
+    {
+        return;
+    }
+
+    const auto direction = (to - from) / length;
+
+    QueryRayCallback<T> callback{visit, length};
+    callback.m_rayDirectionInverse = {
+        direction.getX() == 0.0f ? BT_LARGE_FLOAT : 1.0f / direction.getX(),
+        direction.getY() == 0.0f ? BT_LARGE_FLOAT : 1.0f / direction.getY(),
+        direction.getZ() == 0.0f ? BT_LARGE_FLOAT : 1.0f / direction.getZ()};
+    callback.m_signs[0] = callback.m_rayDirectionInverse.getX() < 0.0f;
+    callback.m_signs[1] = callback.m_rayDirectionInverse.getY() < 0.0f;
+    callback.m_signs[2] = callback.m_rayDirectionInverse.getZ() < 0.0f;
+    callback.m_lambda_max = length;
+
+    broadphase.rayTest(from, to, callback, -extents, extents);
+}
+
+/**
+ * Dispatcher near callback which skips the narrowphase for pairs involving a ghost object. Trigger volumes only care
+ * about broadphase overlap, so generating contacts for them would be wasted work.
+ *
+ * @param pair
+ *   Overlapping pair from the broadphase.
+ *
+ * @param dispatcher
+ *   Dispatcher running the narrowphase.
+ *
+ * @param dispatch_info
+ *   Settings for the current dispatch.
+ */
+void near_callback(
+    ::btBroadphasePair &pair,
+    ::btCollisionDispatcher &dispatcher,
+    const ::btDispatcherInfo &dispatch_info)
+{
+    const auto *object0 = static_cast<const ::btCollisionObject *>(pair.m_pProxy0->m_clientObject);
+    const auto *object1 = static_cast<const ::btCollisionObject *>(pair.m_pProxy1->m_clientObject);
+
+    if ((::btGhostObject::upcast(object0) != nullptr) || (::btGhostObject::upcast(object1) != nullptr))
+    {
+        return;
+    }
+
+    ::btCollisionDispatcher::defaultNearCallback(pair, dispatcher, dispatch_info);
+}
+
+/**
+ * Helper function to pack a rigid body's index and generation into a single sortable key.
+ *
+ * @param index
+ *   Index of the rigid body.
+ *
+ * @param generation
+ *   Generation of the rigid body.
+ *
+ * @returns
+ *   Key uniquely identifying the rigid body.
+ */
+std::uint64_t overlap_key(std::uint32_t index, std::uint32_t generation)
+{
+    return (static_cast<std::uint64_t>(generation) << 32u) | index;
+}
+
+/**
+ * Debug drawer which records lines rather than drawing them, so the physics thread can draw the world without touching
+ * the scene.
+ */
+class DebugLineRecorder : public ::btIDebugDraw
+{
+  public:
+    /**
+     * Construct a new DebugLineRecorder.
+     *
+     * @param lines
+     *   Collection to append start, end and colour triples to.
+     */
+    DebugLineRecorder(std::vector<bab::Vector3> &lines)
+        : lines_(lines)
+    {
+    }
+
+    /**
+     * Record a debug line, bullet calls this for each line it wants drawn.
+     *
+     * @param from
+     *   The position in world space of the start of the line.
+     *
+     * @param to
+     *   The position in world space of the end of the line.
+     *
+     * @param colour
+     *   The colour of the line.
+     */
+    void drawLine(const ::btVector3 &from, const ::btVector3 &to, const ::btVector3 &colour) override
+    {
+        lines_.push_back(to_engine(from));
+        lines_.push_back(to_engine(to));
+        lines_.push_back(to_engine(colour));
+    }
+
+    // these must be defined but, as with DebugDrawer, we only draw wireframes
+
+    void drawContactPoint(const ::btVector3 &, const ::btVector3 &, ::btScalar, int, const ::btVector3 &) override
+    {
+    }
+
+    void reportErrorWarning(const char *) override
+    {
+    }
+
+    void draw3dText(const ::btVector3 &, const char *) override
+    {
+    }
+
+    void setDebugMode(int) override
+    {
+    }
+
+    int getDebugMode() const override
+    {
+        return ::btIDebugDraw::DBG_DrawWireframe;
+    }
+
+  private:
+    /** Collection lines are recorded into. */
+    std::vector<bab::Vector3> &lines_;
+};
+
+/**
+ * Number of queries to hand to a thread at a time when a batch is split across the thread pool.
+ */
+constexpr auto query_grain_size = 64;
+
+/**
+ * Furthest apart two objects' contact point can be and still count as touching. Manifolds keep points until they
+ * separate past the contact breaking threshold, so without this objects that have just come apart still report contact.
+ */
+constexpr ::btScalar touching_distance = 0.001f;
+
+/**
+ * Most objects the 16 bit sweep and prune broadphase can hold, it stores two edges per object per axis in 16 bit
+ * indices and reserves one handle as a sentinel.
+ */
+constexpr std::uint32_t max_16_bit_broadphase_objects = 32766u;
+
+/**
+ * Puts a dbvt broadphase back to finding pairs as objects move when it goes out of scope, so a batch insert which
+ * throws part way through doesn't leave the broadphase deferring collision forever.
+ */
+struct DeferredCollideGuard
+{
+    /**
+     * Turn off deferred collision, if there is a broadphase.
+     */
+    ~DeferredCollideGuard()
+    {
+        if (broadphase != nullptr)
+        {
+            broadphase->m_deferedcollide = false;
+        }
+    }
+
+    /** The broadphase to reset, may be nullptr. */
+    ::btDbvtBroadphase *broadphase;
+};
+
+}
+
+namespace bab
+{
+
+PhysicsManager::PhysicsManager(const PhysicsConfig &config)
+    : thread_pool_(nullptr)
+    , thread_count_(std::max(config.thread_count, 1u))
+    , collision_config_()
+    , collision_dispatcher_()
+    , broadphase_()
+    , dbvt_broadphase_(nullptr)
+    , solver_()
+    , ghost_pair_callback_()
+    , overlap_filter_()
+    , world_()
+    , shape_cache_()
+    , collision_layers_()
+    , rigid_bodies_()
+    , debug_drawer_(nullptr)
+    , debug_lines_()
+    , debug_recorder_(std::make_unique<DebugLineRecorder>(debug_lines_))
+    , collision_callbacks_()
+    , collision_event_callbacks_()
+    , contact_pairs_()
+    , forgotten_bodies_()
+    , current_contact_pairs_()
+    , collision_events_()
+    , collision_tick_ends_()
+    , callback_bodies_()
+    , fired_collision_events_()
+    , fired_collision_tick_ends_()
+    , fired_callbacks_()
+    , fired_collision_event_callbacks_()
+    , dispatch_thread_()
+    , pending_removals_()
+    , disabled_filters_()
+    , triggers_()
+    , free_triggers_()
+    , trigger_event_callbacks_()
+    , current_overlaps_()
+    , trigger_events_()
+    , trigger_tick_ends_()
+    , fired_trigger_events_()
+    , fired_trigger_tick_ends_()
+    , fired_trigger_event_callbacks_()
+    , fixed_time_step_(1.0f / config.tick_rate)
+    , max_substeps_(config.max_substeps)
+    , accumulator_(0.0f)
+    , tick_(0u)
+    , dirty_bodies_()
+    , moved_bodies_()
+    , lod_simulation_distance_(config.lod_simulation_distance)
+    , lod_update_interval_(config.lod_update_interval)
+    , lod_focus_points_()
+    , lod_islands_in_range_()
+    , snapshot_manifolds_()
+    , world_mutex_()
+    , snapshots_()
+    , physics_thread_()
+{
+    assert(lod_update_interval_ != 0u);
+
+    switch (config.broadphase)
+    {
+        case BroadphaseType::DBVT:
+        {
+            auto dbvt_broadphase = std::make_unique<::btDbvtBroadphase>();
+            dbvt_broadphase_ = dbvt_broadphase.get();
+            broadphase_ = std::move(dbvt_broadphase);
+            break;
+        }
+        case BroadphaseType::AXIS_SWEEP:
+        case BroadphaseType::AXIS_SWEEP_32:
+            if (config.max_broadphase_objects < 2u)
+            {
+                throw std::runtime_error(
+                    std::format("max_broadphase_objects must be at least 2, got {}", config.max_broadphase_objects));
+            }
+
+            // too many objects for 16 bit indices is still a valid scene, so quietly widen rather than fail
+            if ((config.broadphase == BroadphaseType::AXIS_SWEEP) &&
+                (config.max_broadphase_objects <= max_16_bit_broadphase_objects))
+            {
+                broadphase_ = std::make_unique<::btAxisSweep3>(
+                    to_bullet(config.world_min),
+                    to_bullet(config.world_max),
+                    static_cast<unsigned short>(config.max_broadphase_objects));
+            }
+            else
+            {
+                broadphase_ = std::make_unique<::bt32BitAxisSweep3>(
+                    to_bullet(config.world_min), to_bullet(config.world_max), config.max_broadphase_objects);
+            }
+            break;
+    }
+
+    switch (config.collision_configuration)
+    {
+        case CollisionConfigurationType::DEFAULT:
+            collision_config_ = std::make_unique<::btDefaultCollisionConfiguration>();
+            break;
+        case CollisionConfigurationType::BOX_PLANE:
+            collision_config_ = std::make_unique<BoxPlaneCollisionConfiguration>();
+            break;
+    }
+
+    if (config.thread_count > 1u)
+    {
+        // bullet only supports a single global task scheduler, so every world shares one and limits its own loops to
+        // the configured thread count when stepping
+        thread_pool_ = std::addressof(TaskScheduler::instance().thread_pool());
+
+        auto solver_pool = std::make_unique<::btConstraintSolverPoolMt>(static_cast<int>(thread_count_));
+        collision_dispatcher_ = std::make_unique<::btCollisionDispatcherMt>(collision_config_.get());
+        world_ = std::make_unique<::btDiscreteDynamicsWorldMt>(
+            collision_dispatcher_.get(), broadphase_.get(), solver_pool.get(), nullptr, collision_config_.get());
+        solver_ = std::move(solver_pool);
+    }
+    else
+    {
+        collision_dispatcher_ = std::make_unique<::btCollisionDispatcher>(collision_config_.get());
+        solver_ = std::make_unique<::btSequentialImpulseConstraintSolver>();
+        world_ = std::make_unique<::btDiscreteDynamicsWorld>(
+            collision_dispatcher_.get(), broadphase_.get(), solver_.get(), collision_config_.get());
+    }
+
+    // every broadphase owns a pair cache, so ghost objects and filtering work whichever one was chosen
+    broadphase_->getOverlappingPairCache()->setInternalGhostPairCallback(&ghost_pair_callback_);
+    broadphase_->getOverlappingPairCache()->setOverlapFilterCallback(&overlap_filter_);
+    collision_dispatcher_->setNearCallback(near_callback);
+    world_->setGravity({-0.0f, -10.0f, 0.0f});
+
+    if (config.asynchronous)
+    {
+        physics_thread_ = std::jthread{[this](std::stop_token stop_token) { run_asynchronous(stop_token); }};
+    }
+}
+
+PhysicsManager::~PhysicsManager()
+{
+    // stop the physics thread before we start tearing down the world it is simulating
+    if (physics_thread_.joinable())
+    {
+        physics_thread_.request_stop();
+        physics_thread_.join();
+    }
+
+    for (auto index = 0u; index < rigid_bodies_.capacity(); ++index)
+    {
+        if (rigid_bodies_.is_alive(index))
+        {
+            world_->removeRigidBody(std::addressof(rigid_bodies_.body(index)));
+        }
+    }
+
+    for (const auto &trigger : triggers_)
+    {
+        if (trigger.ghost)
+        {
+            world_->removeCollisionObject(trigger.ghost.get());
+        }
+    }
+}
+
+RigidBody PhysicsManager::add_static_rigid_body(
+    const Vector3 &half_extent,
+    const Vector3 &position,
+    const std::optional<CollisionFilter> &filter)
+{
+    std::scoped_lock lock{world_mutex_};
+
+    ::btTransform start_transform{};
+    start_transform.setIdentity();
+    start_transform.setOrigin(to_bullet(position));
+
+    auto *shape = shape_cache_.acquire_box(to_bullet(half_extent));
+
+    const auto index = rigid_bodies_.create(start_transform, tick_, dirty_bodies_, 0.0f, shape, {0.0f, 0.0f, 0.0f});
+    auto &rigid_body = rigid_bodies_.body(index);
+
+    rigid_body.setFriction(1.0f);
+    add_to_world(rigid_body, filter.value_or(collision_layers_.filter("static")));
+
+    return {std::addressof(rigid_bodies_), index, rigid_bodies_.generation(index)};
+}
+
+RigidBody PhysicsManager::add_dynamic_rigid_body(
+    const Vector3 &half_extent,
+    const Vector3 &position,
+    float mass,
+    const std::optional<CollisionFilter> &filter)
+{
+    std::scoped_lock lock{world_mutex_};
+
+    return create_dynamic_box(half_extent, position, mass, filter.value_or(collision_layers_.filter("default")));
+}
+
+std::vector<RigidBody> PhysicsManager::add_dynamic_rigid_bodies(
+    std::span<const BoxRigidBodyDesc> descs,
+    const std::optional<CollisionFilter> &filter)
+{
+    std::scoped_lock lock{world_mutex_};
+
+    const auto count = static_cast<std::uint32_t>(descs.size());
+    rigid_bodies_.reserve(count);
+    world_->getCollisionObjectArray().reserve(world_->getNumCollisionObjects() + static_cast<int>(count));
+
+    const auto body_filter = filter.value_or(collision_layers_.filter("default"));
+
+    std::vector<RigidBody> rigid_bodies{};
+    rigid_bodies.reserve(descs.size());
+
+    // with deferred collision the dbvt inserts leaves without querying both trees for new pairs on every insert
+    const DeferredCollideGuard guard{dbvt_broadphase_};
+    if (dbvt_broadphase_ != nullptr)
+    {
+        dbvt_broadphase_->m_deferedcollide = true;
+    }
+
+    for (const auto &desc : descs)
+    {
+        rigid_bodies.push_back(create_dynamic_box(desc.half_extent, desc.position, desc.mass, body_filter));
+    }
+
+    if (dbvt_broadphase_ != nullptr)
+    {
+        // rebuild the tree the incremental inserts left behind, then find the pairs of the whole batch with a single
+        // tree against tree pass, after which the guard puts the broadphase back to finding pairs as objects move
+        dbvt_broadphase_->m_sets[0].optimizeTopDown();
+        dbvt_broadphase_->calculateOverlappingPairs(collision_dispatcher_.get());
+    }
+
+    return rigid_bodies;
+}
+
+RigidBody PhysicsManager::add_static_plane_rigid_body(
+    const Vector3 &normal,
+    float distance,
+    const std::optional<CollisionFilter> &filter)
+{
+    std::scoped_lock lock{world_mutex_};
+
+    ::btTransform start_transform{};
+    start_transform.setIdentity();
+
+    auto *shape = shape_cache_.acquire_static_plane(to_bullet(normal), distance);
+
+    const auto index = rigid_bodies_.create(start_transform, tick_, dirty_bodies_, 0.0f, shape, {0.0f, 0.0f, 0.0f});
+    auto &rigid_body = rigid_bodies_.body(index);
+
+    rigid_body.setFriction(1.0f);
+    add_to_world(rigid_body, filter.value_or(collision_layers_.filter("static")));
+
+    return {std::addressof(rigid_bodies_), index, rigid_bodies_.generation(index)};
+}
+
+RigidBody PhysicsManager::add_static_mesh_rigid_body(
+    const std::string &mesh_name,
+    const Vector3 &position,
+    const Quaternion &orientation,
+    const Vector3 &scale,
+    const std::optional<CollisionFilter> &filter)
+{
+    std::scoped_lock lock{world_mutex_};
+
+    const ::btTransform start_transform{to_bullet(orientation), to_bullet(position)};
+
+    // triangle meshes have no inertia, bullet only supports them on static bodies
+    auto *shape = shape_cache_.acquire_triangle_mesh(mesh_name, to_bullet(scale));
+
+    const auto index = rigid_bodies_.create(start_transform, tick_, dirty_bodies_, 0.0f, shape, {0.0f, 0.0f, 0.0f});
+    auto &rigid_body = rigid_bodies_.body(index);
+
+    rigid_body.setFriction(1.0f);
+    add_to_world(rigid_body, filter.value_or(collision_layers_.filter("static")));
+
+    return {std::addressof(rigid_bodies_), index, rigid_bodies_.generation(index)};
+}
+
+void PhysicsManager::remove_rigid_body(const RigidBody &rigid_body)
+{
+    std::scoped_lock lock{world_mutex_};
+
+    // removing an already removed body is harmless, the slot may have been reused so we must not touch it
+    if (!rigid_body.is_valid())
+    {
+        return;
+    }
+
+    // events handed to other callbacks may still refer to the body, so keep it until they have all run
+    if (dispatch_thread_ == std::this_thread::get_id())
+    {
+        pending_removals_.push_back(rigid_body);
+        return;
+    }
+
+    destroy_rigid_body(rigid_body.index_);
+}
+
+void PhysicsManager::disable_rigid_body(const RigidBody &rigid_body)
+{
+    std::scoped_lock lock{world_mutex_};
+
+    assert(rigid_body.is_valid());
+
+    auto &bullet_rigid_body = rigid_bodies_.body(rigid_body.index_);
+    if (!bullet_rigid_body.isInWorld())
+    {
+        return;
+    }
+
+    // the filter lives on the broadphase proxy, which is destroyed when the body leaves the world
+    if (rigid_body.index_ >= disabled_filters_.size())
+    {
+        disabled_filters_.resize(rigid_bodies_.capacity());
+    }
+
+    const auto *proxy = bullet_rigid_body.getBroadphaseHandle();
+    disabled_filters_[rigid_body.index_] = {
+        static_cast<std::uint32_t>(proxy->m_collisionFilterGroup),
+        static_cast<std::uint32_t>(proxy->m_collisionFilterMask)};
+
+    world_->removeRigidBody(std::addressof(bullet_rigid_body));
+    forget_rigid_body(rigid_body.index_);
+}
+
+void PhysicsManager::enable_rigid_body(
+    const RigidBody &rigid_body,
+    const Vector3 &position,
+    const Quaternion &orientation)
+{
+    std::scoped_lock lock{world_mutex_};
+
+    assert(rigid_body.is_valid());
+
+    auto &bullet_rigid_body = rigid_bodies_.body(rigid_body.index_);
+    assert(!bullet_rigid_body.isInWorld());
+
+    const ::btTransform transform{to_bullet(orientation), to_bullet(position)};
+    const ::btVector3 zero{0.0f, 0.0f, 0.0f};
+
+    bullet_rigid_body.setWorldTransform(transform);
+    bullet_rigid_body.setInterpolationWorldTransform(transform);
+    bullet_rigid_body.setLinearVelocity(zero);
+    bullet_rigid_body.setInterpolationLinearVelocity(zero);
+    bullet_rigid_body.setAngularVelocity(zero);
+    bullet_rigid_body.setInterpolationAngularVelocity(zero);
+    bullet_rigid_body.clearForces();
+    bullet_rigid_body.forceActivationState(ACTIVE_TAG);
+    bullet_rigid_body.setDeactivationTime(0.0f);
+
+    // reset both ticks of the motion state so the body doesn't interpolate from where it was disabled
+    rigid_bodies_.motion_state(rigid_body.index_).reset(transform);
+
+    add_to_world(bullet_rigid_body, disabled_filters_[rigid_body.index_]);
+}
+
+TriggerVolume PhysicsManager::add_trigger_volume(
+    const Vector3 &half_extent,
+    const Vector3 &position,
+    const std::optional<CollisionFilter> &filter)
+{
+    std::scoped_lock lock{world_mutex_};
+
+    auto index = static_cast<std::uint32_t>(triggers_.size());
+    if (!free_triggers_.empty())
+    {
+        index = free_triggers_.back();
+        free_triggers_.pop_back();
+    }
+    else
+    {
+        triggers_.push_back({nullptr, 0u, {}});
+    }
+
+    ::btTransform transform{};
+    transform.setIdentity();
+    transform.setOrigin(to_bullet(position));
+
+    auto &trigger = triggers_[index];
+    trigger.ghost = std::make_unique<::btGhostObject>();
+    trigger.ghost->setWorldTransform(transform);
+    trigger.ghost->setCollisionShape(shape_cache_.acquire_box(to_bullet(half_extent)));
+    trigger.ghost->setCollisionFlags(trigger.ghost->getCollisionFlags() | ::btCollisionObject::CF_NO_CONTACT_RESPONSE);
+    trigger.ghost->setUserIndex(static_cast<int>(index));
+
+    const auto trigger_filter = filter.value_or(collision_layers_.filter("sensor"));
+    world_->addCollisionObject(
+        trigger.ghost.get(), static_cast<int>(trigger_filter.group), static_cast<int>(trigger_filter.mask));
+
+    return {index, trigger.generation};
+}
+
+void PhysicsManager::remove_trigger_volume(const TriggerVolume &trigger)
+{
+    std::scoped_lock lock{world_mutex_};
+
+    if ((trigger.index_ >= triggers_.size()) || (triggers_[trigger.index_].generation != trigger.generation_) ||
+        !triggers_[trigger.index_].ghost)
+    {
+        return;
+    }
+
+    auto &slot = triggers_[trigger.index_];
+    world_->removeCollisionObject(slot.ghost.get());
+    shape_cache_.release(slot.ghost->getCollisionShape());
+
+    slot.ghost.reset();
+    slot.overlaps.clear();
+    ++slot.generation;
+
+    free_triggers_.push_back(trigger.index_);
+}
+
+void PhysicsManager::set_lod_focus_points(std::span<const Vector3> focus_points)
+{
+    std::scoped_lock lock{world_mutex_};
+
+    lod_focus_points_.assign(std::cbegin(focus_points), std::cend(focus_points));
+}
+
+CollisionLayers &PhysicsManager::collision_layers()
+{
+    return collision_layers_;
+}
+
+void PhysicsManager::set_collision_filter(const RigidBody &rigid_body, const CollisionFilter &filter)
+{
+    std::scoped_lock lock{world_mutex_};
+
+    assert(rigid_body.is_valid());
+
+    // a disabled body has no proxy to hold the filter, it is applied when the body is enabled
+    auto &bullet_rigid_body = rigid_bodies_.body(rigid_body.index_);
+    if (!bullet_rigid_body.isInWorld())
+    {
+        disabled_filters_[rigid_body.index_] = filter;
+        return;
+    }
+
+    // bullet only applies filters when pairs are created, so re-adding the body is the only way to drop existing pairs
+    world_->removeRigidBody(std::addressof(bullet_rigid_body));
+    add_to_world(bullet_rigid_body, filter);
+}
+
+CollisionFilter PhysicsManager::collision_filter(const RigidBody &rigid_body)
+{
+    std::scoped_lock lock{world_mutex_};
+
+    assert(rigid_body.is_valid());
+
+    const auto &bullet_rigid_body = rigid_bodies_.body(rigid_body.index_);
+    if (!bullet_rigid_body.isInWorld())
+    {
+        return disabled_filters_[rigid_body.index_];
+    }
+
+    const auto *proxy = bullet_rigid_body.getBroadphaseHandle();
+    return {
+        static_cast<std::uint32_t>(proxy->m_collisionFilterGroup),
+        static_cast<std::uint32_t>(proxy->m_collisionFilterMask)};
+}
+
+void PhysicsManager::register_collision_callback(const RigidBody &rigid_body, std::function<bool()> callback)
+{
+    std::scoped_lock lock{world_mutex_};
+
+    assert(rigid_body.is_valid());
+
+    // an existing callback is kept, unless it is empty because it is currently running
+    const auto *bullet_rigid_body = std::addressof(rigid_bodies_.body(rigid_body.index_));
+    if (auto &existing = collision_callbacks_[bullet_rigid_body]; !existing)
+    {
+        existing = std::move(callback);
+    }
+}
+
+void PhysicsManager::register_collision_event_callback(std::function<void(std::span<const CollisionEvent>)> callback)
+{
+    std::scoped_lock lock{world_mutex_};
+
+    collision_event_callbacks_.push_back(std::move(callback));
+}
+
+void PhysicsManager::register_trigger_event_callback(std::function<void(std::span<const TriggerEvent>)> callback)
+{
+    std::scoped_lock lock{world_mutex_};
+
+    trigger_event_callbacks_.push_back(std::move(callback));
+}
+
+void PhysicsManager::set_debug_drawer(DebugDrawer *debug_drawer)
+{
+    std::scoped_lock lock{world_mutex_};
+
+    debug_drawer_ = debug_drawer;
+
+    // the physics thread cannot touch the scene, so it records lines into each snapshot for update() to draw
+    if (is_asynchronous() && (debug_drawer != nullptr))
+    {
+        world_->setDebugDrawer(debug_recorder_.get());
+    }
+    else
+    {
+        world_->setDebugDrawer(debug_drawer);
+    }
+}
+
+void PhysicsManager::update(float delta)
+{
+    if (is_asynchronous())
+    {
+        // the physics thread advances the simulation, drawing from the snapshot means we never wait on it
+        if (debug_drawer_ != nullptr)
+        {
+            const auto &lines = latest_snapshot().debug_lines_;
+            for (auto i = 0u; (i + 2u) < lines.size(); i += 3u)
+            {
+                debug_drawer_->drawLine(to_bullet(lines[i]), to_bullet(lines[i + 1u]), to_bullet(lines[i + 2u]));
+            }
+        }
+
+        return;
+    }
+
+    simulate(delta);
+    dispatch_events();
+
+    if (debug_drawer_ != nullptr)
+    {
+        world_->debugDrawWorld();
+    }
+}
+
+bool PhysicsManager::is_asynchronous() const
+{
+    return physics_thread_.joinable();
+}
+
+const TransformSnapshot &PhysicsManager::latest_snapshot()
+{
+    return snapshots_.read();
+}
+
+void PhysicsManager::raycast_batch(std::span<const Ray> rays, std::span<Hit> hits)
+{
+    assert(rays.size() == hits.size());
+
+    std::scoped_lock lock{world_mutex_};
+
+    run_queries(static_cast<std::int32_t>(rays.size()), [this, rays, hits](std::int32_t begin, std::int32_t end) {
+        for (auto i = begin; i < end; ++i)
+        {
+            hits[i] = raycast(rays[i]);
+        }
+    });
+}
+
+void PhysicsManager::sweep_batch(std::span<const BoxSweep> sweeps, std::span<Hit> hits)
+{
+    assert(sweeps.size() == hits.size());
+
+    std::scoped_lock lock{world_mutex_};
+
+    run_queries(static_cast<std::int32_t>(sweeps.size()), [this, sweeps, hits](std::int32_t begin, std::int32_t end) {
+        for (auto i = begin; i < end; ++i)
+        {
+            hits[i] = sweep(sweeps[i]);
+        }
+    });
+}
+
+std::span<const std::uint32_t> PhysicsManager::moved_rigid_bodies()
+{
+    assert(!is_asynchronous());
+
+    moved_bodies_.assign(std::cbegin(dirty_bodies_), std::cend(dirty_bodies_));
+
+    // bodies updated by the latest tick are still moving so stay dirty, as they need interpolating every frame, the
+    // rest have come to rest since the last call and only need syncing once more
+    std::erase_if(dirty_bodies_, [this](std::uint32_t index) {
+        auto &motion_state = rigid_bodies_.motion_state(index);
+        if (motion_state.updated_tick() == tick_)
+        {
+            return false;
+        }
+
+        motion_state.mark_clean();
+        return true;
+    });
+
+    return moved_bodies_;
+}
+
+std::size_t PhysicsManager::snapshot_size()
+{
+    std::scoped_lock lock{world_mutex_};
+
+    return measure_snapshot();
+}
+
+std::size_t PhysicsManager::snapshot(std::span<std::byte> buffer)
+{
+    std::scoped_lock lock{world_mutex_};
+
+    // measured under the same lock as the write, the world may have grown since the caller sized the buffer
+    const auto size = measure_snapshot();
+    if (size > buffer.size())
+    {
+        return 0u;
+    }
+
+    auto offset = sizeof(SnapshotHeader);
+    auto body_count = 0u;
+    auto written = true;
+
+    for (auto index = 0u; index < rigid_bodies_.capacity(); ++index)
+    {
+        if (!rigid_bodies_.is_alive(index))
+        {
+            continue;
+        }
+
+        const auto &body = rigid_bodies_.body(index);
+        if (body.isStaticObject())
+        {
+            continue;
+        }
+
+        BodySnapshot record{};
+        body.getWorldTransform().serializeFloat(record.transform);
+        record.linear_velocity = to_snapshot(body.getLinearVelocity());
+        record.angular_velocity = to_snapshot(body.getAngularVelocity());
+        record.index = index;
+        record.generation = rigid_bodies_.generation(index);
+        record.activation_state = body.getActivationState();
+        record.deactivation_time = body.getDeactivationTime();
+
+        written &= write_record(buffer, offset, record);
+        offset += sizeof(BodySnapshot);
+        ++body_count;
+    }
+
+    // measure_snapshot() has already collected the manifolds
+    const auto first_contact_offset = offset + (snapshot_manifolds_.size() * sizeof(ManifoldSnapshot));
+    auto contact_index = 0u;
+
+    for (const auto *manifold : snapshot_manifolds_)
+    {
+        const auto index_a = static_cast<std::uint32_t>(manifold->getBody0()->getUserIndex());
+        const auto index_b = static_cast<std::uint32_t>(manifold->getBody1()->getUserIndex());
+        const auto manifold_contacts = static_cast<std::uint32_t>(manifold->getNumContacts());
+
+        written &= write_record(
+            buffer,
+            offset,
+            ManifoldSnapshot{
+                index_a,
+                rigid_bodies_.generation(index_a),
+                index_b,
+                rigid_bodies_.generation(index_b),
+                contact_index,
+                manifold_contacts});
+        offset += sizeof(ManifoldSnapshot);
+
+        for (auto i = 0u; i < manifold_contacts; ++i)
+        {
+            const auto &point = manifold->getContactPoint(static_cast<int>(i));
+
+            written &= write_record(
+                buffer,
+                record_offset(first_contact_offset, sizeof(ContactSnapshot), contact_index++),
+                ContactSnapshot{
+                    to_snapshot(point.m_localPointA),
+                    to_snapshot(point.m_localPointB),
+                    to_snapshot(point.m_positionWorldOnA),
+                    to_snapshot(point.m_positionWorldOnB),
+                    to_snapshot(point.m_normalWorldOnB),
+                    to_snapshot(point.m_lateralFrictionDir1),
+                    to_snapshot(point.m_lateralFrictionDir2),
+                    point.m_distance1,
+                    point.m_combinedFriction,
+                    point.m_combinedRollingFriction,
+                    point.m_combinedSpinningFriction,
+                    point.m_combinedRestitution,
+                    point.m_appliedImpulse,
+                    point.m_appliedImpulseLateral1,
+                    point.m_appliedImpulseLateral2,
+                    point.m_partId0,
+                    point.m_partId1,
+                    point.m_index0,
+                    point.m_index1,
+                    point.m_contactPointFlags,
+                    point.m_lifeTime});
+        }
+    }
+
+    written &= write_record(
+        buffer,
+        0u,
+        SnapshotHeader{tick_, body_count, static_cast<std::uint32_t>(snapshot_manifolds_.size()), contact_index});
+
+    return written ? size : 0u;
+}
+
+bool PhysicsManager::restore(std::span<const std::byte> buffer)
+{
+    std::scoped_lock lock{world_mutex_};
+
+    const auto header = read_record<SnapshotHeader>(buffer, 0u);
+    if (!header)
+    {
+        return false;
+    }
+
+    const auto first_body_offset = sizeof(SnapshotHeader);
+    const auto first_manifold_offset = first_body_offset + (header->body_count * sizeof(BodySnapshot));
+    const auto first_contact_offset = first_manifold_offset + (header->manifold_count * sizeof(ManifoldSnapshot));
+    const auto size = first_contact_offset + (header->contact_count * sizeof(ContactSnapshot));
+
+    if (size > buffer.size())
+    {
+        return false;
+    }
+
+    const auto manifold_key = [](std::uint32_t index_a, std::uint32_t index_b) {
+        return (static_cast<std::uint64_t>(index_a) << 32u) | index_b;
+    };
+
+    // check every record before touching the world, so a corrupt snapshot leaves the simulation as it was
+    for (auto i = 0u; i < header->body_count; ++i)
+    {
+        const auto record =
+            *read_record<BodySnapshot>(buffer, record_offset(first_body_offset, sizeof(BodySnapshot), i));
+
+        if ((record.activation_state < ACTIVE_TAG) || (record.activation_state > DISABLE_SIMULATION))
+        {
+            return false;
+        }
+    }
+
+    for (auto i = 0u; i < header->manifold_count; ++i)
+    {
+        const auto record =
+            *read_record<ManifoldSnapshot>(buffer, record_offset(first_manifold_offset, sizeof(ManifoldSnapshot), i));
+
+        if ((record.contact_count > MANIFOLD_CACHE_SIZE) || (record.first_contact > header->contact_count) ||
+            (record.contact_count > (header->contact_count - record.first_contact)))
+        {
+            return false;
+        }
+
+        // the binary search below relies on the records being sorted
+        if (i != 0u)
+        {
+            const auto previous = *read_record<ManifoldSnapshot>(
+                buffer, record_offset(first_manifold_offset, sizeof(ManifoldSnapshot), i - 1u));
+
+            if (manifold_key(record.index_a, record.index_b) < manifold_key(previous.index_a, previous.index_b))
+            {
+                return false;
+            }
+        }
+    }
+
+    tick_ = header->tick;
+
+    for (auto i = 0u; i < header->body_count; ++i)
+    {
+        const auto record =
+            *read_record<BodySnapshot>(buffer, record_offset(first_body_offset, sizeof(BodySnapshot), i));
+        if (!rigid_bodies_.is_alive(record.index, record.generation))
+        {
+            continue;
+        }
+
+        auto &body = rigid_bodies_.body(record.index);
+
+        ::btTransform transform{};
+        transform.deSerializeFloat(record.transform);
+        const auto linear_velocity = from_snapshot(record.linear_velocity);
+        const auto angular_velocity = from_snapshot(record.angular_velocity);
+
+        // only bodies that have moved need their broadphase bounds updating, which is the expensive part
+        const auto moved = !(transform == body.getWorldTransform());
+
+        body.setWorldTransform(transform);
+        body.setInterpolationWorldTransform(transform);
+        body.setLinearVelocity(linear_velocity);
+        body.setInterpolationLinearVelocity(linear_velocity);
+        body.setAngularVelocity(angular_velocity);
+        body.setInterpolationAngularVelocity(angular_velocity);
+        body.forceActivationState(record.activation_state);
+        body.setDeactivationTime(record.deactivation_time);
+
+        rigid_bodies_.motion_state(record.index).reset(transform);
+
+        if (moved)
+        {
+            world_->updateSingleAabb(std::addressof(body));
+        }
+    }
+
+    // find pairs for the restored bounds now rather than next tick, which also drops the manifolds of pairs that no
+    // longer overlap and brings every trigger's ghost overlaps in line with the snapshot
+    broadphase_->calculateOverlappingPairs(collision_dispatcher_.get());
+
+    for (auto &trigger : triggers_)
+    {
+        if (trigger.ghost)
+        {
+            gather_trigger_overlaps(trigger);
+            std::swap(trigger.overlaps, current_overlaps_);
+        }
+    }
+
+    // restore the contacts of every live manifold that was in the snapshot and clear the rest, so the solver warm
+    // starts exactly as it did when the snapshot was taken
+    for (auto i = 0; i < collision_dispatcher_->getNumManifolds(); ++i)
+    {
+        auto *manifold = collision_dispatcher_->getManifoldByIndexInternal(i);
+        manifold->clearManifold();
+
+        const auto *body_a = ::btRigidBody::upcast(manifold->getBody0());
+        const auto *body_b = ::btRigidBody::upcast(manifold->getBody1());
+        if ((body_a == nullptr) || (body_b == nullptr))
+        {
+            continue;
+        }
+
+        const auto index_a = static_cast<std::uint32_t>(body_a->getUserIndex());
+        const auto index_b = static_cast<std::uint32_t>(body_b->getUserIndex());
+        const auto key = manifold_key(index_a, index_b);
+
+        // records are sorted by their body indices so we can binary search them in place
+        auto first = 0u;
+        auto count = header->manifold_count;
+        while (count > 0u)
+        {
+            const auto step = count / 2u;
+            const auto record = *read_record<ManifoldSnapshot>(
+                buffer, record_offset(first_manifold_offset, sizeof(ManifoldSnapshot), first + step));
+
+            if (manifold_key(record.index_a, record.index_b) < key)
+            {
+                first += step + 1u;
+                count -= step + 1u;
+            }
+            else
+            {
+                count = step;
+            }
+        }
+
+        if (first == header->manifold_count)
+        {
+            continue;
+        }
+
+        const auto record = *read_record<ManifoldSnapshot>(
+            buffer, record_offset(first_manifold_offset, sizeof(ManifoldSnapshot), first));
+
+        if ((manifold_key(record.index_a, record.index_b) != key) ||
+            (record.generation_a != rigid_bodies_.generation(index_a)) ||
+            (record.generation_b != rigid_bodies_.generation(index_b)))
+        {
+            continue;
+        }
+
+        for (auto j = 0u; j < record.contact_count; ++j)
+        {
+            const auto contact = *read_record<ContactSnapshot>(
+                buffer, record_offset(first_contact_offset, sizeof(ContactSnapshot), record.first_contact + j));
+
+            ::btManifoldPoint point{
+                from_snapshot(contact.local_point_a),
+                from_snapshot(contact.local_point_b),
+                from_snapshot(contact.normal_world_on_b),
+                contact.distance};
+            point.m_positionWorldOnA = from_snapshot(contact.position_world_on_a);
+            point.m_positionWorldOnB = from_snapshot(contact.position_world_on_b);
+            point.m_lateralFrictionDir1 = from_snapshot(contact.lateral_friction_dir_1);
+            point.m_lateralFrictionDir2 = from_snapshot(contact.lateral_friction_dir_2);
+            point.m_combinedFriction = contact.combined_friction;
+            point.m_combinedRollingFriction = contact.combined_rolling_friction;
+            point.m_combinedSpinningFriction = contact.combined_spinning_friction;
+            point.m_combinedRestitution = contact.combined_restitution;
+            point.m_appliedImpulse = contact.applied_impulse;
+            point.m_appliedImpulseLateral1 = contact.applied_impulse_lateral_1;
+            point.m_appliedImpulseLateral2 = contact.applied_impulse_lateral_2;
+            point.m_partId0 = contact.part_id_0;
+            point.m_partId1 = contact.part_id_1;
+            point.m_index0 = contact.index_0;
+            point.m_index1 = contact.index_1;
+            point.m_contactPointFlags = contact.contact_point_flags;
+            point.m_lifeTime = contact.life_time;
+
+            // a saved point may be a predictive one beyond the breaking threshold, flagging it as predictive only
+            // stops bullet asserting on its distance
+            manifold->addManifoldPoint(point, true);
+        }
+    }
+
+    // contacts now match the snapshot, so the next tick must diff against them rather than what was touching before
+    forgotten_bodies_.clear();
+    gather_contact_pairs();
+    std::swap(contact_pairs_, current_contact_pairs_);
+
+    // anything queued happened after the snapshot was taken
+    collision_events_.clear();
+    collision_tick_ends_.clear();
+    trigger_events_.clear();
+    trigger_tick_ends_.clear();
+    callback_bodies_.clear();
+
+    // restored activation states include level of detail freezes from when the snapshot was taken, so bring them in
+    // line with the current focus points now rather than leaving bodies frozen in range
+    update_lod();
+
+    return true;
+}
+
+float PhysicsManager::interpolation_alpha() const
+{
+    return accumulator_ / fixed_time_step_;
+}
+
+std::uint32_t PhysicsManager::simulate(float delta)
+{
+    accumulator_ += delta;
+
+    auto steps = 0u;
+    while ((accumulator_ >= fixed_time_step_) && (steps < max_substeps_))
+    {
+        ++tick_;
+
+        if ((tick_ % lod_update_interval_) == 0u)
+        {
+            update_lod();
+        }
+
+        TaskScheduler::set_thread_limit(thread_count_);
+
+        // passing zero substeps makes bullet run exactly one step of the supplied length
+        world_->stepSimulation(fixed_time_step_, 0, fixed_time_step_);
+
+        accumulator_ -= fixed_time_step_;
+        ++steps;
+
+        collect_collision_events();
+        collect_trigger_events();
+    }
+
+    // if we hit the substep cap then drop the time we could not simulate, otherwise a slow frame would leave a backlog
+    // that makes every following frame slower
+    if (accumulator_ >= fixed_time_step_)
+    {
+        accumulator_ = std::fmod(accumulator_, fixed_time_step_);
+    }
+
+    return steps;
+}
+
+void PhysicsManager::run_asynchronous(std::stop_token stop_token)
+{
+    auto last_time = std::chrono::steady_clock::now();
+
+    while (!stop_token.stop_requested())
+    {
+        const auto now = std::chrono::steady_clock::now();
+        const auto delta = std::chrono::duration<float>(now - last_time).count();
+        last_time = now;
+
+        auto time_to_next_tick = 0.0f;
+
+        {
+            std::scoped_lock lock{world_mutex_};
+
+            if (simulate(delta) != 0u)
+            {
+                publish_snapshot();
+            }
+
+            time_to_next_tick = fixed_time_step_ - accumulator_;
+        }
+
+        // callbacks run without the lock, so they can call back into the manager
+        dispatch_events();
+
+        // sleep outside the lock so the main thread can add and remove bodies between ticks
+        std::this_thread::sleep_for(std::chrono::duration<float>(time_to_next_tick));
+    }
 }
 
-namespace bab
+void PhysicsManager::publish_snapshot()
 {
+    auto &snapshot = snapshots_.write_buffer();
+    const auto capacity = rigid_bodies_.capacity();
 
-PhysicsManager::PhysicsManager()
-    : collision_config_()
-    , collision_dispatcher_(&collision_config_)
-    , broadphase_()
-    , solver_()
-    , ghost_pair_callback_()
-    , world_(&collision_dispatcher_, &broadphase_, &solver_, &collision_config_)
-    , shapes_()
-    , motion_states_()
-    , rigid_bodies_()
-    , debug_drawer_(nullptr)
-    , collision_callbacks_()
+    // buffers are reused between ticks so this only allocates when the pool has grown
+    snapshot.generations_.resize(capacity);
+    snapshot.previous_.resize(capacity);
+    snapshot.current_.resize(capacity);
+
+    for (auto index = 0u; index < capacity; ++index)
+    {
+        snapshot.generations_[index] = rigid_bodies_.generation(index);
+
+        if (!rigid_bodies_.is_alive(index))
+        {
+            continue;
+        }
+
+        const auto &motion_state = rigid_bodies_.motion_state(index);
+
+        snapshot.previous_[index] = {
+            to_engine(motion_state.interpolated_origin(0.0f)), to_engine(motion_state.interpolated_rotation(0.0f))};
+        snapshot.current_[index] = {
+            to_engine(motion_state.interpolated_origin(1.0f)), to_engine(motion_state.interpolated_rotation(1.0f))};
+    }
+
+    debug_lines_.clear();
+    if (debug_drawer_ != nullptr)
+    {
+        world_->debugDrawWorld();
+    }
+    std::swap(snapshot.debug_lines_, debug_lines_);
+
+    snapshot.tick_ = tick_;
+    snapshot.published_ = std::chrono::steady_clock::now();
+    snapshot.tick_length_ = fixed_time_step_;
+
+    snapshots_.publish();
+}
+
+bool PhysicsManager::is_in_lod_range(const ::btRigidBody &rigid_body) const
 {
-    broadphase_.getOverlappingPairCache()->setInternalGhostPairCallback(&ghost_pair_callback_);
-    world_.setGravity({-0.0f, -10.0f, 0.0f});
+    if ((lod_simulation_distance_ <= 0.0f) || lod_focus_points_.empty())
+    {
+        return true;
+    }
+
+    const auto &origin = rigid_body.getWorldTransform().getOrigin();
+    const auto max_distance_squared = lod_simulation_distance_ * lod_simulation_distance_;
+
+    return std::ranges::any_of(lod_focus_points_, [&](const auto &focus_point) {
+        return origin.distance2(to_bullet(focus_point)) < max_distance_squared;
+    });
 }
 
-PhysicsManager::~PhysicsManager()
+void PhysicsManager::update_lod()
 {
-    for (const auto &body : rigid_bodies_)
+    const auto capacity = rigid_bodies_.capacity();
+
+    const auto is_simulated = [this](std::uint32_t index) {
+        if (!rigid_bodies_.is_alive(index))
+        {
+            return false;
+        }
+
+        const auto &rigid_body = rigid_bodies_.body(index);
+        return !rigid_body.isStaticOrKinematicObject() && rigid_body.isInWorld();
+    };
+
+    // island tags are indices into the world's collision objects, assigned by the last tick
+    lod_islands_in_range_.assign(static_cast<std::size_t>(world_->getNumCollisionObjects()), false);
+
+    const auto island = [this](const ::btRigidBody &rigid_body) -> std::optional<std::size_t> {
+        const auto tag = rigid_body.getIslandTag();
+        if ((tag < 0) || (static_cast<std::size_t>(tag) >= lod_islands_in_range_.size()))
+        {
+            return std::nullopt;
+        }
+
+        return static_cast<std::size_t>(tag);
+    };
+
+    // freezing only part of an island would leave the rest as immovable obstacles for the bodies resting on them, so
+    // any body in range keeps its whole island running
+    for (auto index = 0u; index < capacity; ++index)
+    {
+        if (!is_simulated(index))
+        {
+            continue;
+        }
+
+        const auto &rigid_body = rigid_bodies_.body(index);
+        if (const auto tag = island(rigid_body); tag && is_in_lod_range(rigid_body))
+        {
+            lod_islands_in_range_[*tag] = true;
+        }
+    }
+
+    for (auto index = 0u; index < capacity; ++index)
     {
-        world_.removeRigidBody(body.get());
+        if (!is_simulated(index))
+        {
+            continue;
+        }
+
+        auto &rigid_body = rigid_bodies_.body(index);
+
+        const auto tag = island(rigid_body);
+        const auto in_range = tag ? lod_islands_in_range_[*tag] : is_in_lod_range(rigid_body);
+        const auto frozen = (rigid_body.getActivationState() == DISABLE_SIMULATION);
+
+        if (!in_range && !frozen)
+        {
+            rigid_body.forceActivationState(DISABLE_SIMULATION);
+        }
+        else if (in_range && frozen)
+        {
+            rigid_body.forceActivationState(ACTIVE_TAG);
+            rigid_body.setDeactivationTime(0.0f);
+        }
     }
 }
 
-void PhysicsManager::add_static_rigid_body(const Vector3 &half_extent, const Vector3 &position)
+RigidBody PhysicsManager::create_dynamic_box(
+    const Vector3 &half_extent,
+    const Vector3 &position,
+    float mass,
+    const CollisionFilter &filter)
 {
     ::btTransform start_transform{};
     start_transform.setIdentity();
     start_transform.setOrigin(to_bullet(position));
 
-    shapes_.push_back(std::make_unique<::btBoxShape>(to_bullet(half_extent)));
-    auto *shape = shapes_.back().get();
+    auto *shape = shape_cache_.acquire_box(to_bullet(half_extent));
+    const auto local_inertia = shape_cache_.local_inertia(shape, mass);
+
+    const auto index = rigid_bodies_.create(start_transform, tick_, dirty_bodies_, mass, shape, local_inertia);
+    auto &rigid_body = rigid_bodies_.body(index);
+
+    rigid_body.setFriction(1.0f);
+    add_to_world(rigid_body, filter);
+
+    return {std::addressof(rigid_bodies_), index, rigid_bodies_.generation(index)};
+}
+
+void PhysicsManager::destroy_rigid_body(std::uint32_t index)
+{
+    auto *bullet_rigid_body = std::addressof(rigid_bodies_.body(index));
+
+    // a disabled body has already left the world
+    if (bullet_rigid_body->isInWorld())
+    {
+        world_->removeRigidBody(bullet_rigid_body);
+        forget_rigid_body(index);
+    }
+
+    shape_cache_.release(bullet_rigid_body->getCollisionShape());
+    rigid_bodies_.destroy(index);
+}
+
+void PhysicsManager::flush_pending_removals()
+{
+    for (const auto &rigid_body : pending_removals_)
+    {
+        // the same body may have been removed twice
+        if (rigid_body.is_valid())
+        {
+            destroy_rigid_body(rigid_body.index_);
+        }
+    }
+
+    pending_removals_.clear();
+}
+
+void PhysicsManager::forget_rigid_body(std::uint32_t index)
+{
+    const auto *bullet_rigid_body = std::addressof(rigid_bodies_.body(index));
 
-    motion_states_.push_back(std::make_unique<::btDefaultMotionState>(start_transform));
-    auto *motion_state = motion_states_.back().get();
+    collision_callbacks_.erase(bullet_rigid_body);
 
-    ::btRigidBody::btRigidBodyConstructionInfo info{0.0f, motion_state, shape, {0.0f, 0.0f, 0.0f}};
+    // its contacts are dropped before the next walk, so a new body in the same slot doesn't inherit them
+    forgotten_bodies_.push_back(bullet_rigid_body);
 
-    rigid_bodies_.emplace_back(std::make_unique<::btRigidBody>(info));
-    auto *rigid_body = rigid_bodies_.back().get();
+    if (auto &motion_state = rigid_bodies_.motion_state(index); motion_state.is_dirty())
+    {
+        std::erase(dirty_bodies_, index);
+        motion_state.mark_clean();
+    }
+}
 
-    rigid_body->setFriction(1.0f);
-    world_.addRigidBody(rigid_body);
+void PhysicsManager::add_to_world(::btRigidBody &rigid_body, const CollisionFilter &filter)
+{
+    world_->addRigidBody(std::addressof(rigid_body), static_cast<int>(filter.group), static_cast<int>(filter.mask));
 }
 
-RigidBody PhysicsManager::add_dynamic_rigid_body(const Vector3 &half_extent, const Vector3 &position, float mass)
+std::size_t PhysicsManager::measure_snapshot()
 {
-    ::btTransform start_transform{};
-    start_transform.setIdentity();
-    start_transform.setOrigin(to_bullet(position));
+    auto body_count = std::size_t{0u};
+    for (auto index = 0u; index < rigid_bodies_.capacity(); ++index)
+    {
+        if (rigid_bodies_.is_alive(index) && !rigid_bodies_.body(index).isStaticObject())
+        {
+            ++body_count;
+        }
+    }
 
-    ::btVector3 local_inertia{0.0f, 0.0f, 0.0f};
+    const auto contact_count = collect_snapshot_manifolds();
+
+    return sizeof(SnapshotHeader) + (body_count * sizeof(BodySnapshot)) +
+           (snapshot_manifolds_.size() * sizeof(ManifoldSnapshot)) + (contact_count * sizeof(ContactSnapshot));
+}
 
-    shapes_.push_back(std::make_unique<::btBoxShape>(to_bullet(half_extent)));
-    auto *shape = shapes_.back().get();
-    shape->calculateLocalInertia(mass, local_inertia);
+std::uint32_t PhysicsManager::collect_snapshot_manifolds()
+{
+    snapshot_manifolds_.clear();
+    auto contact_count = 0u;
 
-    motion_states_.push_back(std::make_unique<::btDefaultMotionState>(start_transform));
-    auto *motion_state = motion_states_.back().get();
+    for (auto i = 0; i < collision_dispatcher_->getNumManifolds(); ++i)
+    {
+        const auto *manifold = collision_dispatcher_->getManifoldByIndexInternal(i);
 
-    ::btRigidBody::btRigidBodyConstructionInfo info{mass, motion_state, shape, local_inertia};
+        if ((manifold->getNumContacts() == 0) || (::btRigidBody::upcast(manifold->getBody0()) == nullptr) ||
+            (::btRigidBody::upcast(manifold->getBody1()) == nullptr))
+        {
+            continue;
+        }
 
-    rigid_bodies_.emplace_back(std::make_unique<::btRigidBody>(info));
-    auto *rigid_body = rigid_bodies_.back().get();
+        snapshot_manifolds_.push_back(manifold);
+        contact_count += static_cast<std::uint32_t>(manifold->getNumContacts());
+    }
 
-    rigid_body->setFriction(1.0f);
-    world_.addRigidBody(rigid_body);
+    std::ranges::sort(snapshot_manifolds_, [](const auto *a, const auto *b) {
+        return std::pair{a->getBody0()->getUserIndex(), a->getBody1()->getUserIndex()} <
+               std::pair{b->getBody0()->getUserIndex(), b->getBody1()->getUserIndex()};
+    });
 
-    return {rigid_body};
+    return contact_count;
 }
 
-void PhysicsManager::register_collision_callback(const RigidBody &rigid_body, std::function<bool()> callback)
+void PhysicsManager::gather_contact_pairs()
 {
-    auto *bullet_rigid_body = rigid_body.rigid_body_;
-    collision_callbacks_.try_emplace(bullet_rigid_body, std::move(callback));
+    current_contact_pairs_.clear();
+
+    // the dispatcher has already done the narrowphase for this tick, so just collect the manifolds it left behind
+    const auto manifold_count = collision_dispatcher_->getNumManifolds();
+    for (auto i = 0; i < manifold_count; ++i)
+    {
+        const auto *manifold = collision_dispatcher_->getManifoldByIndexInternal(i);
+
+        ContactPair pair{manifold->getBody0(), manifold->getBody1(), {0.0f, 0.0f, 0.0f}, 0.0f};
+        if (pair.object_b < pair.object_a)
+        {
+            std::swap(pair.object_a, pair.object_b);
+        }
+
+        // only points which are actually touching count, the rest are kept by bullet in case the objects close again
+        auto deepest = touching_distance;
+        auto touching = false;
+        for (auto j = 0; j < manifold->getNumContacts(); ++j)
+        {
+            const auto &contact = manifold->getContactPoint(j);
+            if (contact.getDistance() > touching_distance)
+            {
+                continue;
+            }
+
+            touching = true;
+            pair.impulse += contact.getAppliedImpulse();
+
+            if (contact.getDistance() <= deepest)
+            {
+                deepest = contact.getDistance();
+                pair.point = contact.getPositionWorldOnB();
+            }
+        }
+
+        if (touching)
+        {
+            current_contact_pairs_.push_back(pair);
+        }
+    }
+
+    std::sort(std::begin(current_contact_pairs_), std::end(current_contact_pairs_), contact_pair_less<ContactPair>);
+
+    // a pair of objects can have more than one manifold, merge them so each pair only produces one event
+    auto write = std::begin(current_contact_pairs_);
+    for (auto read = std::begin(current_contact_pairs_); read != std::end(current_contact_pairs_); ++read)
+    {
+        if ((write != std::begin(current_contact_pairs_)) && !contact_pair_less(*std::prev(write), *read))
+        {
+            std::prev(write)->impulse += read->impulse;
+        }
+        else
+        {
+            *write++ = *read;
+        }
+    }
+    current_contact_pairs_.erase(write, std::end(current_contact_pairs_));
 }
 
-void PhysicsManager::set_debug_drawer(DebugDrawer *debug_drawer)
+void PhysicsManager::collect_collision_events()
 {
-    debug_drawer_ = debug_drawer;
-    world_.setDebugDrawer(debug_drawer);
+    const auto first_event = collision_events_.size();
+
+    // drop the contacts of every body that left the world since last tick in one pass, rather than a pass per body
+    if (!forgotten_bodies_.empty())
+    {
+        std::ranges::sort(forgotten_bodies_);
+        std::erase_if(contact_pairs_, [this](const auto &pair) {
+            return std::ranges::binary_search(forgotten_bodies_, pair.object_a) ||
+                   std::ranges::binary_search(forgotten_bodies_, pair.object_b);
+        });
+
+        forgotten_bodies_.clear();
+    }
+
+    gather_contact_pairs();
+
+    const auto add_event = [this](CollisionEventType type, const ContactPair &pair, ::btScalar impulse) {
+        const auto *body_a = ::btRigidBody::upcast(pair.object_a);
+        const auto *body_b = ::btRigidBody::upcast(pair.object_b);
+
+        // only rigid bodies are exposed to the engine
+        if ((body_a == nullptr) || (body_b == nullptr))
+        {
+            return;
+        }
+
+        collision_events_.push_back(
+            {type, to_handle(body_a), to_handle(body_b), to_engine(pair.point), static_cast<float>(impulse)});
+
+        if (type == CollisionEventType::END)
+        {
+            return;
+        }
+
+        // per body callbacks are fired along with the events, once the lock is released
+        for (const auto *body : {body_a, body_b})
+        {
+            if (collision_callbacks_.contains(body))
+            {
+                callback_bodies_.push_back(body);
+            }
+        }
+    };
+
+    // both collections are sorted so a single merge walk tells us which contacts are new, ongoing or finished
+    auto previous = std::cbegin(contact_pairs_);
+    auto current = std::cbegin(current_contact_pairs_);
+    while ((previous != std::cend(contact_pairs_)) || (current != std::cend(current_contact_pairs_)))
+    {
+        if ((previous == std::cend(contact_pairs_)) ||
+            ((current != std::cend(current_contact_pairs_)) && contact_pair_less(*current, *previous)))
+        {
+            add_event(CollisionEventType::BEGIN, *current, current->impulse);
+            ++current;
+        }
+        else if ((current == std::cend(current_contact_pairs_)) || contact_pair_less(*previous, *current))
+        {
+            add_event(CollisionEventType::END, *previous, 0.0f);
+            ++previous;
+        }
+        else
+        {
+            add_event(CollisionEventType::PERSIST, *current, current->impulse);
+            ++previous;
+            ++current;
+        }
+    }
+
+    std::swap(contact_pairs_, current_contact_pairs_);
+
+    if (collision_events_.size() != first_event)
+    {
+        collision_tick_ends_.push_back(collision_events_.size());
+    }
+}
+
+void PhysicsManager::gather_trigger_overlaps(const Trigger &trigger)
+{
+    // the ghost pair callback keeps the ghost's overlap list in step with the broadphase, so there is no narrowphase
+    // work here
+    current_overlaps_.clear();
+    for (auto i = 0; i < trigger.ghost->getNumOverlappingObjects(); ++i)
+    {
+        if (const auto *body = ::btRigidBody::upcast(trigger.ghost->getOverlappingObject(i)); body != nullptr)
+        {
+            const auto body_index = static_cast<std::uint32_t>(body->getUserIndex());
+            current_overlaps_.push_back(overlap_key(body_index, rigid_bodies_.generation(body_index)));
+        }
+    }
+
+    std::ranges::sort(current_overlaps_);
 }
 
-void PhysicsManager::update()
+void PhysicsManager::collect_trigger_events()
 {
-    world_.stepSimulation(0.16f);
+    const auto first_event = trigger_events_.size();
 
-    // test for collisions on all rigid bodies with a registered callback
-    for (auto &[rigid_body, callback] : collision_callbacks_)
+    for (auto index = 0u; index < triggers_.size(); ++index)
     {
-        CollisionCallback collision_check{};
-        world_.contactTest(rigid_body, collision_check);
+        auto &trigger = triggers_[index];
+        if (!trigger.ghost)
+        {
+            continue;
+        }
+
+        gather_trigger_overlaps(trigger);
 
-        if (collision_check)
+        if (current_overlaps_.empty() && trigger.overlaps.empty())
         {
-            // if the callback returns true then we can clear it
-            if (callback())
+            continue;
+        }
+
+        const auto add_event = [&](TriggerEventType type, std::uint64_t key) {
+            trigger_events_.push_back(
+                {type,
+                 {index, trigger.generation},
+                 {std::addressof(rigid_bodies_),
+                  static_cast<std::uint32_t>(key & 0xffffffffu),
+                  static_cast<std::uint32_t>(key >> 32u)}});
+        };
+
+        // both collections are sorted so a single merge walk tells us which bodies entered and which left, a removed
+        // body has already been dropped by the broadphase so it leaves here with its stale handle
+        auto previous = std::cbegin(trigger.overlaps);
+        auto current = std::cbegin(current_overlaps_);
+        while ((previous != std::cend(trigger.overlaps)) || (current != std::cend(current_overlaps_)))
+        {
+            if ((previous == std::cend(trigger.overlaps)) ||
+                ((current != std::cend(current_overlaps_)) && (*current < *previous)))
+            {
+                add_event(TriggerEventType::ENTER, *current++);
+            }
+            else if ((current == std::cend(current_overlaps_)) || (*previous < *current))
+            {
+                add_event(TriggerEventType::EXIT, *previous++);
+            }
+            else
             {
-                collision_callbacks_[rigid_body] = nullptr;
+                ++previous;
+                ++current;
             }
         }
+
+        std::swap(trigger.overlaps, current_overlaps_);
+    }
+
+    if (trigger_events_.size() != first_event)
+    {
+        trigger_tick_ends_.push_back(trigger_events_.size());
     }
+}
 
-    // remove all entries with cleared callbacks
-    std::erase_if(collision_callbacks_, [](const auto &element) { return !std::get<1>(element); });
+void PhysicsManager::dispatch_events()
+{
+    {
+        std::scoped_lock lock{world_mutex_};
 
-    if (debug_drawer_ != nullptr)
+        if (callback_bodies_.empty() && collision_events_.empty() && trigger_events_.empty())
+        {
+            return;
+        }
+
+        // take everything the callbacks need now, new events can be queued by the physics thread while they run
+        std::swap(fired_collision_events_, collision_events_);
+        std::swap(fired_collision_tick_ends_, collision_tick_ends_);
+        std::swap(fired_trigger_events_, trigger_events_);
+        std::swap(fired_trigger_tick_ends_, trigger_tick_ends_);
+        collision_events_.clear();
+        collision_tick_ends_.clear();
+        trigger_events_.clear();
+        trigger_tick_ends_.clear();
+
+        fired_collision_event_callbacks_ = collision_event_callbacks_;
+        fired_trigger_event_callbacks_ = trigger_event_callbacks_;
+
+        // move each per body callback out of the map once, leaving an empty placeholder, so a callback registering
+        // another cannot rehash the map out from under it
+        std::ranges::sort(callback_bodies_);
+        const auto duplicates = std::ranges::unique(callback_bodies_);
+        callback_bodies_.erase(std::begin(duplicates), std::end(duplicates));
+
+        for (const auto *body : callback_bodies_)
+        {
+            if (const auto callback = collision_callbacks_.find(body);
+                (callback != std::end(collision_callbacks_)) && callback->second)
+            {
+                fired_callbacks_.push_back({body, std::move(callback->second), false});
+                callback->second = nullptr;
+            }
+        }
+        callback_bodies_.clear();
+
+        dispatch_thread_ = std::this_thread::get_id();
+    }
+
+    // fire each per body callback once, if the callback returns true then we can clear it
+    for (auto &callback : fired_callbacks_)
+    {
+        callback.consumed = callback.function();
+    }
+
+    const auto fire_ticks = [](const auto &callbacks, const auto &events, const auto &tick_ends) {
+        std::size_t tick_begin = 0u;
+        for (const auto tick_end : tick_ends)
+        {
+            const auto tick_events = std::span{events}.subspan(tick_begin, tick_end - tick_begin);
+            for (const auto &callback : callbacks)
+            {
+                callback(tick_events);
+            }
+
+            tick_begin = tick_end;
+        }
+    };
+
+    fire_ticks(fired_collision_event_callbacks_, fired_collision_events_, fired_collision_tick_ends_);
+    fire_ticks(fired_trigger_event_callbacks_, fired_trigger_events_, fired_trigger_tick_ends_);
+
+    std::scoped_lock lock{world_mutex_};
+
+    for (auto &callback : fired_callbacks_)
+    {
+        // a missing or filled slot means the body left the world, or was given a new callback, while this one ran
+        const auto entry = collision_callbacks_.find(callback.body);
+        if ((entry == std::end(collision_callbacks_)) || entry->second)
+        {
+            continue;
+        }
+
+        if (callback.consumed)
+        {
+            collision_callbacks_.erase(entry);
+        }
+        else
+        {
+            entry->second = std::move(callback.function);
+        }
+    }
+
+    fired_callbacks_.clear();
+    dispatch_thread_ = {};
+
+    flush_pending_removals();
+}
+
+void PhysicsManager::run_queries(std::int32_t count, const std::function<void(std::int32_t, std::int32_t)> &body)
+{
+    if (thread_pool_)
+    {
+        thread_pool_->parallel_for(0, count, query_grain_size, body, thread_count_);
+    }
+    else
     {
-        world_.debugDrawWorld();
+        body(0, count);
     }
 }
 
-}
\ No newline at end of file
+Hit PhysicsManager::raycast(const Ray &ray)
+{
+    const auto from = to_bullet(ray.from);
+    const auto to = to_bullet(ray.to);
+    const ::btTransform from_transform{::btQuaternion::getIdentity(), from};
+    const ::btTransform to_transform{::btQuaternion::getIdentity(), to};
+
+    ::btCollisionWorld::ClosestRayResultCallback result{from, to};
+
+    const auto visit = [&](::btCollisionObject *object) {
+        if (is_queryable(object))
+        {
+            ::btCollisionWorld::rayTestSingle(
+                from_transform,
+                to_transform,
+                object,
+                object->getCollisionShape(),
+                object->getWorldTransform(),
+                result);
+        }
+
+        return result.m_closestHitFraction;
+    };
+
+    walk_broadphase(dbvt_broadphase_, *broadphase_, from, to, ::btVector3{0.0f, 0.0f, 0.0f}, visit);
+
+    if (!result.hasHit())
+    {
+        return {};
+    }
+
+    return {
+        to_handle(result.m_collisionObject),
+        to_engine(result.m_hitPointWorld),
+        to_engine(result.m_hitNormalWorld),
+        result.m_closestHitFraction};
+}
+
+Hit PhysicsManager::sweep(const BoxSweep &sweep)
+{
+    const auto from = to_bullet(sweep.from);
+    const auto to = to_bullet(sweep.to);
+    const ::btTransform from_transform{::btQuaternion::getIdentity(), from};
+    const ::btTransform to_transform{::btQuaternion::getIdentity(), to};
+
+    // box shapes do not allocate so a temporary one is cheaper than going through the shape cache
+    const ::btBoxShape shape{to_bullet(sweep.half_extent)};
+
+    ::btVector3 aabb_min{};
+    ::btVector3 aabb_max{};
+    shape.getAabb(::btTransform::getIdentity(), aabb_min, aabb_max);
+
+    ::btCollisionWorld::ClosestConvexResultCallback result{from, to};
+
+    const auto visit = [&](::btCollisionObject *object) {
+        if (is_queryable(object))
+        {
+            ::btCollisionWorld::objectQuerySingle(
+                &shape,
+                from_transform,
+                to_transform,
+                object,
+                object->getCollisionShape(),
+                object->getWorldTransform(),
+                result,
+                0.0f);
+        }
+
+        return result.m_closestHitFraction;
+    };
+
+    walk_broadphase(dbvt_broadphase_, *broadphase_, from, to, aabb_max, visit);
+
+    if (!result.hasHit())
+    {
+        return {};
+    }
+
+    return {
+        to_handle(result.m_hitCollisionObject),
+        to_engine(result.m_hitPointWorld),
+        to_engine(result.m_hitNormalWorld),
+        result.m_closestHitFraction};
+}
+
+RigidBody PhysicsManager::to_handle(const ::btCollisionObject *object)
+{
+    const auto index = static_cast<std::uint32_t>(object->getUserIndex());
+    return {std::addressof(rigid_bodies_), index, rigid_bodies_.generation(index)};
+}
+
+}
@@ -1,26 +1,103 @@
 #include "render_entity.h"
 
+#include <cassert>
+#include <string>
+
 #include "quaternion.h"
 #include "vector3.h"
 
 #include "Ogre.h"
+#include "OgreInstancedEntity.h"
 
 namespace bab
 {
 
 RenderEntity::RenderEntity(::Ogre::SceneNode *node)
     : node_(node)
+    , instanced_entity_(nullptr)
+{
+}
+
+RenderEntity::RenderEntity(::Ogre::InstancedEntity *instanced_entity)
+    : node_(nullptr)
+    , instanced_entity_(instanced_entity)
 {
 }
 
 void RenderEntity::set_position(const Vector3 &position)
 {
+    if (instanced_entity_ != nullptr)
+    {
+        instanced_entity_->setPosition(position);
+        return;
+    }
+
     node_->setPosition(position);
 }
 
 void RenderEntity::set_orientation(const Quaternion &orientation)
 {
+    if (instanced_entity_ != nullptr)
+    {
+        instanced_entity_->setOrientation(orientation);
+        return;
+    }
+
+    node_->setOrientation(orientation);
+}
+
+void RenderEntity::set_transform(const Vector3 &position, const Quaternion &orientation)
+{
+    if (instanced_entity_ != nullptr)
+    {
+        // only rebuild the instance matrix once for both changes
+        instanced_entity_->setPosition(position, false);
+        instanced_entity_->setOrientation(orientation);
+        return;
+    }
+
+    node_->setPosition(position);
     node_->setOrientation(orientation);
 }
 
+void RenderEntity::set_material(const std::string &material_name)
+{
+    if (instanced_entity_ != nullptr)
+    {
+        return;
+    }
+
+    static_cast<::Ogre::Entity *>(node_->getAttachedObject(0))->setMaterialName(material_name);
+}
+
+void RenderEntity::detach()
+{
+    if (instanced_entity_ != nullptr)
+    {
+        assert(instanced_entity_->isInUse());
+
+        instanced_entity_->setInUse(false);
+        return;
+    }
+
+    assert(node_->getParentSceneNode() != nullptr);
+
+    node_->getParentSceneNode()->removeChild(node_);
+}
+
+void RenderEntity::attach()
+{
+    if (instanced_entity_ != nullptr)
+    {
+        assert(!instanced_entity_->isInUse());
+
+        instanced_entity_->setInUse(true);
+        return;
+    }
+
+    assert(node_->getParentSceneNode() == nullptr);
+
+    node_->getCreator()->getRootSceneNode()->addChild(node_);
+}
+
 }
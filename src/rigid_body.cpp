@@ -1,6 +1,12 @@
 #include "rigid_body.h"
 
+#include <cassert>
+#include <cstdint>
+
+#include "motion_state.h"
 #include "quaternion.h"
+#include "rigid_body_pool.h"
+#include "transform.h"
 #include "vector3.h"
 
 #include "BulletDynamics/Dynamics/btRigidBody.h"
@@ -43,21 +49,59 @@ bab::Quaternion to_engine(const ::btQuaternion &quaternion)
 namespace bab
 {
 
-RigidBody::RigidBody(::btRigidBody *rigid_body)
-    : rigid_body_(rigid_body)
+RigidBody::RigidBody(RigidBodyPool *pool, std::uint32_t index, std::uint32_t generation)
+    : pool_(pool)
+    , index_(index)
+    , generation_(generation)
 {
 }
 
 Vector3 RigidBody::position() const
 {
-    const auto transform = rigid_body_->getWorldTransform();
+    assert(is_valid());
+    const auto &transform = pool_->body(index_).getWorldTransform();
     return to_engine(transform.getOrigin());
 }
 
 Quaternion RigidBody::orientation() const
 {
-    const auto transform = rigid_body_->getWorldTransform();
+    assert(is_valid());
+    const auto &transform = pool_->body(index_).getWorldTransform();
     return to_engine(transform.getRotation());
 }
 
+Vector3 RigidBody::interpolated_position(float alpha) const
+{
+    assert(is_valid());
+    return to_engine(pool_->motion_state(index_).interpolated_origin(alpha));
+}
+
+Quaternion RigidBody::interpolated_orientation(float alpha) const
+{
+    assert(is_valid());
+    return to_engine(pool_->motion_state(index_).interpolated_rotation(alpha));
+}
+
+Transform RigidBody::interpolated_transform(float alpha) const
+{
+    assert(is_valid());
+    const auto &motion_state = pool_->motion_state(index_);
+    return {to_engine(motion_state.interpolated_origin(alpha)), to_engine(motion_state.interpolated_rotation(alpha))};
+}
+
+bool RigidBody::is_valid() const
+{
+    return pool_->is_alive(index_, generation_);
+}
+
+std::uint32_t RigidBody::index() const
+{
+    return index_;
+}
+
+std::uint32_t RigidBody::generation() const
+{
+    return generation_;
+}
+
 }
@@ -0,0 +1,157 @@
+#include "rigid_body_pool.h"
+
+#include <cassert>
+#include <cstdint>
+#include <limits>
+#include <memory>
+#include <new>
+#include <vector>
+
+#include "motion_state.h"
+
+#include "BulletCollision/CollisionShapes/btCollisionShape.h"
+#include "BulletDynamics/Dynamics/btRigidBody.h"
+#include "LinearMath/btTransform.h"
+#include "LinearMath/btVector3.h"
+
+namespace
+{
+
+/** Marker for the end of the free list. */
+constexpr auto no_free_slot = std::numeric_limits<std::uint32_t>::max();
+
+}
+
+namespace bab
+{
+
+RigidBodyPool::RigidBodyPool()
+    : blocks_()
+    , free_head_(no_free_slot)
+    , size_(0u)
+{
+}
+
+RigidBodyPool::~RigidBodyPool()
+{
+    for (auto index = 0u; index < capacity(); ++index)
+    {
+        if (is_alive(index))
+        {
+            destroy(index);
+        }
+    }
+}
+
+std::uint32_t RigidBodyPool::create(
+    const ::btTransform &start_transform,
+    const std::uint64_t &tick,
+    std::vector<std::uint32_t> &dirty_list,
+    ::btScalar mass,
+    ::btCollisionShape *shape,
+    const ::btVector3 &local_inertia)
+{
+    if (free_head_ == no_free_slot)
+    {
+        add_block();
+    }
+
+    const auto index = free_head_;
+    auto &free_slot = slot(index);
+    free_head_ = free_slot.next_free;
+
+    auto *motion_state = new (free_slot.motion_state) MotionState{start_transform, tick, index, dirty_list};
+    auto *body = new (free_slot.body)::btRigidBody{
+        ::btRigidBody::btRigidBodyConstructionInfo{mass, motion_state, shape, local_inertia}};
+
+    // store our index in the body, so we can get back to the slot from bullet callbacks
+    body->setUserIndex(static_cast<int>(index));
+
+    free_slot.alive = true;
+    ++size_;
+
+    return index;
+}
+
+void RigidBodyPool::destroy(std::uint32_t index)
+{
+    assert(is_alive(index));
+
+    std::destroy_at(std::addressof(body(index)));
+    std::destroy_at(std::addressof(motion_state(index)));
+
+    auto &used_slot = slot(index);
+    used_slot.alive = false;
+    ++used_slot.generation;
+    used_slot.next_free = free_head_;
+    free_head_ = index;
+    --size_;
+}
+
+bool RigidBodyPool::is_alive(std::uint32_t index) const
+{
+    return (index < capacity()) && slot(index).alive;
+}
+
+bool RigidBodyPool::is_alive(std::uint32_t index, std::uint32_t generation) const
+{
+    return is_alive(index) && (slot(index).generation == generation);
+}
+
+::btRigidBody &RigidBodyPool::body(std::uint32_t index) const
+{
+    return *std::launder(reinterpret_cast<::btRigidBody *>(slot(index).body));
+}
+
+MotionState &RigidBodyPool::motion_state(std::uint32_t index) const
+{
+    return *std::launder(reinterpret_cast<MotionState *>(slot(index).motion_state));
+}
+
+std::uint32_t RigidBodyPool::generation(std::uint32_t index) const
+{
+    return slot(index).generation;
+}
+
+void RigidBodyPool::reserve(std::uint32_t count)
+{
+    blocks_.reserve(blocks_.size() + ((count + block_size - 1u) / block_size));
+
+    while ((capacity() - size_) < count)
+    {
+        add_block();
+    }
+}
+
+std::uint32_t RigidBodyPool::capacity() const
+{
+    return static_cast<std::uint32_t>(blocks_.size()) * block_size;
+}
+
+std::uint32_t RigidBodyPool::size() const
+{
+    return size_;
+}
+
+RigidBodyPool::Slot &RigidBodyPool::slot(std::uint32_t index) const
+{
+    return blocks_[index / block_size]->slots[index % block_size];
+}
+
+void RigidBodyPool::add_block()
+{
+    // thread the new slots onto the front of the free list in reverse, so the lowest new index is used first
+    const auto first_index = capacity();
+    blocks_.push_back(std::make_unique_for_overwrite<Block>());
+
+    for (auto i = block_size; i > 0u; --i)
+    {
+        auto &new_slot = blocks_.back()->slots[i - 1u];
+        new_slot.generation = 0u;
+        new_slot.next_free = free_head_;
+        new_slot.alive = false;
+        free_head_ = first_index + i - 1u;
+    }
+}
+
+}
@@ -0,0 +1,24 @@
+#include "scene_entity.h"
+
+#include <cstdint>
+
+namespace bab
+{
+
+SceneEntity::SceneEntity(std::uint32_t index, std::uint32_t generation)
+    : index_(index)
+    , generation_(generation)
+{
+}
+
+std::uint32_t SceneEntity::index() const
+{
+    return index_;
+}
+
+std::uint32_t SceneEntity::generation() const
+{
+    return generation_;
+}
+
+}
@@ -1,57 +1,353 @@
 #include "scene_manager.h"
 
+#include <chrono>
+#include <cstdint>
 #include <functional>
+#include <limits>
+#include <map>
+#include <mutex>
+#include <optional>
+#include <span>
 #include <string>
+#include <tuple>
+#include <utility>
+#include <vector>
 
+#include "box_rigid_body_desc.h"
+#include "component_store.h"
+#include "cube_desc.h"
 #include "graphics_manager.h"
 #include "physics_manager.h"
+#include "quaternion.h"
 #include "render_entity.h"
 #include "rigid_body.h"
+#include "scene_entity.h"
+#include "thread_pool.h"
+#include "transform.h"
+#include "transform_snapshot.h"
 #include "vector3.h"
 
+namespace
+{
+
+/**
+ * Marker in SceneManager::rigid_body_entities_ for rigid bodies that have no entity.
+ */
+constexpr auto no_entity = std::numeric_limits<std::uint32_t>::max();
+
+/**
+ * Number of entities handed to a thread at a time by the per-frame sync passes.
+ */
+constexpr auto sync_chunk_size = 256;
+
+/**
+ * Scale from a cube's render scale to the half extents of its rigid body.
+ */
+constexpr auto bullet_ogre_scale_factor = 50.0f;
+
+}
+
 namespace bab
 {
 
-SceneManager::SceneManager(GraphicsManager &gm, PhysicsManager &pm)
+SceneManager::SceneManager(GraphicsManager &gm, PhysicsManager &pm, ThreadPool *thread_pool)
     : gm_(gm)
     , pm_(pm)
     , physics_debug_object_(gm.add_manual_object())
     , debug_drawer_(physics_debug_object_)
-    , entities_()
+    , components_(thread_pool)
+    , cube_keys_()
+    , pools_()
+    , rigid_body_entities_()
+    , despawn_mutex_()
+    , pending_despawns_()
+    , despawning_()
 {
     pm_.set_debug_drawer(&debug_drawer_);
 
-    // ensure the manual object for drawing physics debug information is correctly stopped/started at frame end/begin
-    gm_.register_frame_start_callback([this] { physics_debug_object_.end(); });
-    gm_.register_frame_end_callback([this] { physics_debug_object_.begin(); });
+    // ensure the manual object for drawing physics debug information is correctly stopped/started at frame end/begin,
+    // stopping only once the physics step has drawn into it
+    gm_.add_frame_task("physics_debug", {"physics"}, [this](float) { physics_debug_object_.end(); });
+    gm_.register_frame_end_callback([this](float) { physics_debug_object_.begin(); });
+
+    // despawns requested by collision callbacks wait until physics has finished with the bodies for this frame
+    gm_.add_frame_task("despawn", {"physics"}, [this](float) { flush_despawns(); });
 
-    // synchronise the rigid body position/orientation with its associated render entity
-    gm_.register_frame_start_callback([this] {
-        for (auto &[render_entity, rigid_body] : entities_)
+    // synchronise the rigid body position/orientation with its associated render entity, interpolating between the last
+    // two physics ticks so movement is smooth regardless of the render rate
+    gm_.add_frame_task("transform_sync", {"physics", "despawn"}, [this](float) {
+        auto &transforms = components_.transforms();
+
+        if (pm_.is_asynchronous())
         {
-            render_entity.set_position(rigid_body.position());
-            render_entity.set_orientation(rigid_body.orientation());
+            // never wait on the physics thread, just use whatever it last published
+            const auto &snapshot = pm_.latest_snapshot();
+            const auto alpha = snapshot.interpolation_alpha(std::chrono::steady_clock::now());
+
+            // interpolating is independent per body so can be split across threads, writing to the scene graph cannot
+            components_.for_each_chunk(
+                components_.rigid_bodies(),
+                sync_chunk_size,
+                [&](std::span<const std::uint32_t> entities, std::span<RigidBody> rigid_bodies) {
+                    for (auto i = 0u; i < entities.size(); ++i)
+                    {
+                        if (const auto transform = snapshot.interpolated_transform(rigid_bodies[i], alpha); transform)
+                        {
+                            transforms.get(entities[i]) = *transform;
+                        }
+                    }
+                });
+
+            apply_transforms();
+
+            return;
+        }
+
+        const auto alpha = pm_.interpolation_alpha();
+        auto &render_entities = components_.render_entities();
+
+        // only bodies bullet has moved need syncing, so a settled scene costs nothing here
+        for (const auto index : pm_.moved_rigid_bodies())
+        {
+            // rigid bodies can be added directly to the PhysicsManager, in which case we have nothing to sync
+            if ((index >= rigid_body_entities_.size()) || (rigid_body_entities_[index] == no_entity))
+            {
+                continue;
+            }
+
+            const auto entity = rigid_body_entities_[index];
+            auto &transform = transforms.get(entity);
+
+            transform = components_.rigid_bodies().get(entity).interpolated_transform(alpha);
+            render_entities.get(entity).set_transform(transform.position, transform.orientation);
         }
     });
 }
 
-void SceneManager::add_cube(
+SceneEntity SceneManager::add_cube(
     const Vector3 &position,
     float scale,
     const std::string &material_name,
     float mass,
-    std::function<bool()> callback)
+    std::function<bool()> callback,
+    bool instanced)
 {
-    const auto bullet_ogre_scale_factor = 50.0f;
+    auto entity = respawn(position, scale, material_name, mass, instanced);
 
-    const auto &[_, rigid_body] = entities_.emplace_back(
-        gm_.add_cube(position, scale, "box_material"),
-        pm_.add_dynamic_rigid_body(Vector3{scale, scale, scale} * bullet_ogre_scale_factor, position, mass));
+    if (!entity)
+    {
+        entity = spawn(
+            instanced ? gm_.add_instanced_cube(position, scale, material_name)
+                      : gm_.add_cube(position, scale, material_name),
+            pm_.add_dynamic_rigid_body(Vector3{scale, scale, scale} * bullet_ogre_scale_factor, position, mass),
+            position,
+            cube_key(scale, mass, material_name, instanced));
+    }
 
     if (callback)
     {
-        pm_.register_collision_callback(rigid_body, callback);
+        pm_.register_collision_callback(components_.rigid_bodies().get(entity->index()), callback);
+    }
+
+    return *entity;
+}
+
+std::vector<SceneEntity> SceneManager::add_cubes(std::span<const CubeDesc> descs)
+{
+    std::vector<std::optional<SceneEntity>> entities(descs.size());
+    std::vector<CubeDesc> new_descs{};
+    std::vector<CubeDesc> new_instanced_descs{};
+    std::vector<BoxRigidBodyDesc> rigid_body_descs{};
+
+    for (auto i = 0u; i < descs.size(); ++i)
+    {
+        const auto &desc = descs[i];
+
+        entities[i] = respawn(desc.position, desc.scale, desc.material_name, desc.mass, desc.instanced);
+
+        if (!entities[i])
+        {
+            (desc.instanced ? new_instanced_descs : new_descs).push_back(desc);
+            rigid_body_descs.push_back(
+                {Vector3{desc.scale, desc.scale, desc.scale} * bullet_ogre_scale_factor, desc.position, desc.mass});
+        }
+    }
+
+    const auto render_entities = gm_.add_cubes(new_descs);
+    const auto instanced_render_entities = gm_.add_instanced_cubes(new_instanced_descs);
+    const auto rigid_bodies = pm_.add_dynamic_rigid_bodies(rigid_body_descs);
+
+    const auto total = components_.size() + rigid_body_descs.size();
+    components_.transforms().reserve(total);
+    components_.rigid_bodies().reserve(total);
+    components_.render_entities().reserve(total);
+
+    // hand out the new entities to the descs the pools could not satisfy, in order
+    auto next_rigid_body = 0u;
+    auto next_render_entity = 0u;
+    auto next_instanced_render_entity = 0u;
+    for (auto i = 0u; i < descs.size(); ++i)
+    {
+        if (entities[i])
+        {
+            continue;
+        }
+
+        const auto &desc = descs[i];
+        const auto &render_entity = desc.instanced ? instanced_render_entities[next_instanced_render_entity++]
+                                                   : render_entities[next_render_entity++];
+
+        entities[i] = spawn(
+            render_entity,
+            rigid_bodies[next_rigid_body++],
+            desc.position,
+            cube_key(desc.scale, desc.mass, desc.material_name, desc.instanced));
+    }
+
+    std::vector<SceneEntity> scene_entities{};
+    scene_entities.reserve(entities.size());
+
+    for (const auto &entity : entities)
+    {
+        scene_entities.push_back(*entity);
+    }
+
+    return scene_entities;
+}
+
+void SceneManager::despawn(const SceneEntity &entity)
+{
+    std::scoped_lock lock{despawn_mutex_};
+
+    pending_despawns_.push_back(entity);
+}
+
+ComponentStore &SceneManager::components()
+{
+    return components_;
+}
+
+SceneManager::CubeKey SceneManager::cube_key(
+    float scale,
+    float mass,
+    const std::string &material_name,
+    bool instanced)
+{
+    return {scale, mass, instanced ? material_name : std::string{}};
+}
+
+std::optional<SceneEntity> SceneManager::respawn(
+    const Vector3 &position,
+    float scale,
+    const std::string &material_name,
+    float mass,
+    bool instanced)
+{
+    auto key = cube_key(scale, mass, material_name, instanced);
+
+    const auto pool = pools_.find(key);
+    if ((pool == std::end(pools_)) || pool->second.empty())
+    {
+        return std::nullopt;
+    }
+
+    auto cube = pool->second.back();
+    pool->second.pop_back();
+
+    // an instanced cube's pool already has the right material
+    if (!instanced)
+    {
+        cube.render_entity.set_material(material_name);
     }
+
+    cube.render_entity.set_transform(position, Quaternion::IDENTITY);
+    cube.render_entity.attach();
+    pm_.enable_rigid_body(cube.rigid_body, position, Quaternion::IDENTITY);
+
+    return spawn(cube.render_entity, cube.rigid_body, position, std::move(key));
+}
+
+SceneEntity SceneManager::spawn(
+    const RenderEntity &render_entity,
+    const RigidBody &rigid_body,
+    const Vector3 &position,
+    CubeKey key)
+{
+    const auto entity = components_.create();
+    const auto index = entity.index();
+
+    // every cube gets the same components in the same order, so its components share a position in each array and the
+    // per-frame passes walk them in lockstep
+    components_.transforms().insert(index, {position, Quaternion::IDENTITY});
+    components_.rigid_bodies().insert(index, rigid_body);
+    components_.render_entities().insert(index, render_entity);
+
+    if (index >= cube_keys_.size())
+    {
+        cube_keys_.resize(index + 1u);
+    }
+
+    cube_keys_[index] = std::move(key);
+    map_rigid_body(rigid_body, index);
+
+    return entity;
 }
 
-}
\ No newline at end of file
+void SceneManager::map_rigid_body(const RigidBody &rigid_body, std::uint32_t entity_index)
+{
+    if (rigid_body.index() >= rigid_body_entities_.size())
+    {
+        rigid_body_entities_.resize(rigid_body.index() + 1u, no_entity);
+    }
+
+    rigid_body_entities_[rigid_body.index()] = entity_index;
+}
+
+void SceneManager::flush_despawns()
+{
+    {
+        std::scoped_lock lock{despawn_mutex_};
+        std::swap(despawning_, pending_despawns_);
+    }
+
+    for (const auto &entity : despawning_)
+    {
+        // the same entity may have been despawned more than once
+        if (!components_.is_alive(entity))
+        {
+            continue;
+        }
+
+        const auto index = entity.index();
+
+        PooledCube cube{components_.render_entities().get(index), components_.rigid_bodies().get(index)};
+
+        cube.render_entity.detach();
+        pm_.disable_rigid_body(cube.rigid_body);
+        map_rigid_body(cube.rigid_body, no_entity);
+
+        components_.destroy(entity);
+
+        // the pool only allocates when it grows past its previous size, after that spawning is allocation free
+        pools_[cube_keys_[index]].push_back(cube);
+    }
+
+    despawning_.clear();
+}
+
+void SceneManager::apply_transforms()
+{
+    const auto &transforms = components_.transforms();
+    auto &render_entities = components_.render_entities();
+
+    const auto entities = render_entities.entities();
+    const auto renderables = render_entities.components();
+
+    for (auto i = 0u; i < entities.size(); ++i)
+    {
+        const auto &transform = transforms.get(entities[i]);
+        renderables[i].set_transform(transform.position, transform.orientation);
+    }
+}
+
+}
@@ -0,0 +1,151 @@
+#include "shape_cache.h"
+
+#include <cassert>
+#include <cstdint>
+#include <limits>
+#include <map>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <utility>
+
+#include "triangle_mesh.h"
+
+#include "BulletCollision/CollisionShapes/btBoxShape.h"
+#include "BulletCollision/CollisionShapes/btBvhTriangleMeshShape.h"
+#include "BulletCollision/CollisionShapes/btCollisionShape.h"
+#include "BulletCollision/CollisionShapes/btScaledBvhTriangleMeshShape.h"
+#include "BulletCollision/CollisionShapes/btStaticPlaneShape.h"
+#include "LinearMath/btScalar.h"
+#include "LinearMath/btVector3.h"
+
+namespace bab
+{
+
+ShapeCache::ShapeCache()
+    : shapes_()
+    , entries_()
+    , inertia_()
+{
+}
+
+::btCollisionShape *ShapeCache::acquire_box(const ::btVector3 &half_extents)
+{
+    return acquire({ShapeType::BOX, {half_extents.getX(), half_extents.getY(), half_extents.getZ()}});
+}
+
+::btCollisionShape *ShapeCache::acquire_static_plane(const ::btVector3 &normal, ::btScalar distance)
+{
+    return acquire({ShapeType::STATIC_PLANE, {normal.getX(), normal.getY(), normal.getZ(), distance}});
+}
+
+::btCollisionShape *ShapeCache::acquire_triangle_mesh(const std::string &mesh_name, const ::btVector3 &scale)
+{
+    return acquire({ShapeType::SCALED_TRIANGLE_MESH, {scale.getX(), scale.getY(), scale.getZ()}, mesh_name});
+}
+
+void ShapeCache::release(const ::btCollisionShape *shape)
+{
+    const auto entry = entries_.find(shape);
+    assert(entry != std::end(entries_));
+
+    auto &[_, cached] = *entry->second;
+    if (--cached.ref_count != 0u)
+    {
+        return;
+    }
+
+    // remove all cached inertia values for the shape, they are contiguous as the shape is the first part of the key
+    const auto first = inertia_.lower_bound({shape, std::numeric_limits<::btScalar>::lowest()});
+    auto last = first;
+    while ((last != std::end(inertia_)) && (last->first.first == shape))
+    {
+        ++last;
+    }
+    inertia_.erase(first, last);
+
+    const auto *parent = cached.parent;
+
+    shapes_.erase(entry->second);
+    entries_.erase(entry);
+
+    // release our hold on any wrapped shape now that we no longer reference it
+    if (parent != nullptr)
+    {
+        release(parent);
+    }
+}
+
+::btVector3 ShapeCache::local_inertia(const ::btCollisionShape *shape, ::btScalar mass)
+{
+    const auto [inertia, inserted] = inertia_.try_emplace({shape, mass}, 0.0f, 0.0f, 0.0f);
+    if (inserted)
+    {
+        shape->calculateLocalInertia(mass, inertia->second);
+    }
+
+    return inertia->second;
+}
+
+std::size_t ShapeCache::size() const
+{
+    return shapes_.size();
+}
+
+::btCollisionShape *ShapeCache::acquire(const Key &key)
+{
+    auto [entry, inserted] = shapes_.try_emplace(key);
+
+    if (inserted)
+    {
+        auto &cached = entry->second;
+
+        // a mesh which fails to load must not leave an empty entry behind for the next acquire to hand out
+        try
+        {
+            switch (key.type)
+            {
+                case ShapeType::BOX:
+                    cached.shape = std::make_unique<::btBoxShape>(
+                        ::btVector3{key.parameters[0], key.parameters[1], key.parameters[2]});
+                    break;
+                case ShapeType::STATIC_PLANE:
+                    cached.shape = std::make_unique<::btStaticPlaneShape>(
+                        ::btVector3{key.parameters[0], key.parameters[1], key.parameters[2]}, key.parameters[3]);
+                    break;
+                case ShapeType::TRIANGLE_MESH:
+                    cached.mesh = std::make_unique<TriangleMesh>(key.name);
+                    cached.shape = cached.mesh->create_shape();
+                    break;
+                case ShapeType::SCALED_TRIANGLE_MESH:
+                {
+                    // every scale wraps the same unscaled mesh, so the triangles and bvh are only loaded once
+                    auto *mesh_shape = acquire({ShapeType::TRIANGLE_MESH, {1.0f, 1.0f, 1.0f}, key.name});
+                    cached.parent = mesh_shape;
+                    cached.shape = std::make_unique<::btScaledBvhTriangleMeshShape>(
+                        static_cast<::btBvhTriangleMeshShape *>(mesh_shape),
+                        ::btVector3{key.parameters[0], key.parameters[1], key.parameters[2]});
+                    break;
+                }
+            }
+        }
+        catch (...)
+        {
+            if (cached.parent != nullptr)
+            {
+                release(cached.parent);
+            }
+
+            shapes_.erase(entry);
+            throw;
+        }
+
+        entries_.emplace(cached.shape.get(), entry);
+    }
+
+    ++entry->second.ref_count;
+
+    return entry->second.shape.get();
+}
+
+}
@@ -0,0 +1,202 @@
+#include "task_graph.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cassert>
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <iterator>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include "job_system.h"
+
+namespace bab
+{
+
+TaskGraph::TaskGraph()
+    : tasks_()
+    , dirty_(false)
+    , remaining_()
+    , outstanding_(0u)
+    , main_thread_mutex_()
+    , main_thread_ready_()
+    , main_thread_wake_()
+{
+}
+
+void TaskGraph::add_task(
+    const std::string &name,
+    const std::vector<std::string> &dependencies,
+    std::function<void(float)> task,
+    bool main_thread)
+{
+    assert(std::ranges::none_of(tasks_, [&name](const auto &existing) { return existing.name == name; }));
+
+    tasks_.push_back({name, dependencies, std::move(task), main_thread, {}, 0u});
+    dirty_ = true;
+}
+
+void TaskGraph::run(float delta, JobSystem &job_system)
+{
+    if (dirty_)
+    {
+        build();
+    }
+
+    if (tasks_.empty())
+    {
+        return;
+    }
+
+    const auto task_count = static_cast<std::uint32_t>(tasks_.size());
+
+    for (auto i = 0u; i < task_count; ++i)
+    {
+        remaining_[i].store(tasks_[i].dependency_count, std::memory_order_relaxed);
+    }
+
+    outstanding_.store(task_count, std::memory_order_relaxed);
+
+    for (auto i = 0u; i < task_count; ++i)
+    {
+        if (tasks_[i].dependency_count == 0u)
+        {
+            schedule(i, delta, job_system);
+        }
+    }
+
+    while (outstanding_.load(std::memory_order_acquire) != 0u)
+    {
+        // tasks which must run here take priority, otherwise help the workers rather than sit idle
+        std::optional<std::uint32_t> ready{};
+
+        {
+            std::scoped_lock lock{main_thread_mutex_};
+            if (!main_thread_ready_.empty())
+            {
+                ready = main_thread_ready_.back();
+                main_thread_ready_.pop_back();
+            }
+        }
+
+        if (ready)
+        {
+            execute(*ready, delta, job_system);
+        }
+        else if (!job_system.run_one())
+        {
+            // nothing to run or steal, so the remaining tasks are all running on workers and only their completion
+            // can give us more to do
+            std::unique_lock lock{main_thread_mutex_};
+            main_thread_wake_.wait(lock, [this] {
+                return !main_thread_ready_.empty() || (outstanding_.load(std::memory_order_acquire) == 0u);
+            });
+        }
+    }
+}
+
+void TaskGraph::build()
+{
+    std::unordered_map<std::string, std::uint32_t> indices{};
+    for (auto i = 0u; i < tasks_.size(); ++i)
+    {
+        indices.emplace(tasks_[i].name, i);
+        tasks_[i].dependants.clear();
+        tasks_[i].dependency_count = 0u;
+    }
+
+    for (auto i = 0u; i < tasks_.size(); ++i)
+    {
+        for (const auto &dependency : tasks_[i].dependencies)
+        {
+            if (const auto index = indices.find(dependency); index != std::cend(indices))
+            {
+                tasks_[index->second].dependants.push_back(i);
+                ++tasks_[i].dependency_count;
+            }
+        }
+    }
+
+#ifndef NDEBUG
+    // every task can only be reached if the graph has no cycles
+    std::vector<std::uint32_t> counts{};
+    std::vector<std::uint32_t> ready{};
+
+    for (auto i = 0u; i < tasks_.size(); ++i)
+    {
+        counts.push_back(tasks_[i].dependency_count);
+        if (counts.back() == 0u)
+        {
+            ready.push_back(i);
+        }
+    }
+
+    auto reached = 0u;
+    while (!ready.empty())
+    {
+        const auto index = ready.back();
+        ready.pop_back();
+        ++reached;
+
+        for (const auto dependant : tasks_[index].dependants)
+        {
+            if (--counts[dependant] == 0u)
+            {
+                ready.push_back(dependant);
+            }
+        }
+    }
+
+    assert(reached == tasks_.size());
+#endif
+
+    remaining_ = std::make_unique<std::atomic<std::uint32_t>[]>(tasks_.size());
+    dirty_ = false;
+}
+
+void TaskGraph::schedule(std::uint32_t index, float delta, JobSystem &job_system)
+{
+    if (tasks_[index].main_thread)
+    {
+        {
+            std::scoped_lock lock{main_thread_mutex_};
+            main_thread_ready_.push_back(index);
+        }
+
+        main_thread_wake_.notify_one();
+    }
+    else
+    {
+        job_system.submit([this, index, delta, &job_system] { execute(index, delta, job_system); });
+    }
+}
+
+void TaskGraph::execute(std::uint32_t index, float delta, JobSystem &job_system)
+{
+    const auto &task = tasks_[index];
+    task.work(delta);
+
+    for (const auto dependant : task.dependants)
+    {
+        if (remaining_[dependant].fetch_sub(1u, std::memory_order_acq_rel) == 1u)
+        {
+            schedule(dependant, delta, job_system);
+        }
+    }
+
+    if (outstanding_.fetch_sub(1u, std::memory_order_acq_rel) == 1u)
+    {
+        // notify under the lock so the main thread can't miss it between checking outstanding_ and sleeping
+        std::scoped_lock lock{main_thread_mutex_};
+        main_thread_wake_.notify_one();
+    }
+}
+
+}
@@ -0,0 +1,121 @@
+#include "task_scheduler.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <functional>
+#include <thread>
+
+#include "thread_pool.h"
+
+#include "LinearMath/btScalar.h"
+#include "LinearMath/btThreads.h"
+
+namespace
+{
+
+/** Whether the calling thread owns a bullet thread index within the scheduler's slots. */
+thread_local auto has_slot = false;
+
+/** Maximum number of threads loops started from the calling thread run on, zero for all. */
+thread_local auto loop_thread_limit = 0u;
+
+/**
+ * Get the number of threads to create the pool with.
+ *
+ * @param first_index
+ *   Bullet thread index of the thread creating the pool.
+ *
+ * @returns
+ *   Number of threads, including the creating thread.
+ */
+std::uint32_t pool_size(unsigned int first_index)
+{
+    // always have at least one worker, so threads without a slot can hand their loops off
+    const auto max_size = static_cast<std::uint32_t>(BT_MAX_THREAD_COUNT) - first_index;
+    return std::clamp(std::thread::hardware_concurrency(), std::min(2u, max_size), max_size);
+}
+
+}
+
+namespace bab
+{
+
+TaskScheduler &TaskScheduler::instance()
+{
+    static TaskScheduler scheduler{};
+    return scheduler;
+}
+
+void TaskScheduler::set_thread_limit(std::uint32_t thread_limit)
+{
+    loop_thread_limit = thread_limit;
+}
+
+TaskScheduler::TaskScheduler()
+    : ::btITaskScheduler("bab")
+    // claim our own index before any worker can, bullet expects the thread installing the scheduler to be index zero
+    , highest_index_(::btGetCurrentThreadIndex())
+    , thread_pool_(pool_size(highest_index_), [this] { claim_slot(); })
+    , slot_count_(static_cast<int>(highest_index_) + 1)
+{
+    has_slot = true;
+    ::btSetTaskScheduler(this);
+}
+
+void TaskScheduler::claim_slot()
+{
+    has_slot = true;
+
+    const auto index = ::btGetCurrentThreadIndex();
+    auto highest = highest_index_.load();
+    while ((index > highest) && !highest_index_.compare_exchange_weak(highest, index))
+    {
+    }
+}
+
+ThreadPool &TaskScheduler::thread_pool()
+{
+    return thread_pool_;
+}
+
+int TaskScheduler::getMaxNumThreads() const
+{
+    return slot_count_;
+}
+
+int TaskScheduler::getNumThreads() const
+{
+    return slot_count_;
+}
+
+void TaskScheduler::setNumThreads(int)
+{
+}
+
+void TaskScheduler::parallelFor(int begin, int end, int grain_size, const ::btIParallelForBody &body)
+{
+    run(begin, end, grain_size, [&body](std::int32_t chunk_begin, std::int32_t chunk_end) {
+        body.forLoop(chunk_begin, chunk_end);
+    });
+}
+
+::btScalar TaskScheduler::parallelSum(int begin, int end, int grain_size, const ::btIParallelSumBody &body)
+{
+    std::atomic<::btScalar> sum{0.0f};
+
+    run(begin, end, grain_size, [&body, &sum](std::int32_t chunk_begin, std::int32_t chunk_end) {
+        sum.fetch_add(body.sumLoop(chunk_begin, chunk_end));
+    });
+
+    return sum;
+}
+
+void TaskScheduler::run(int begin, int end, int grain_size, const std::function<void(std::int32_t, std::int32_t)> &body)
+{
+    // a thread without a slot, such as an asynchronous physics thread, would index past bullet's per thread storage if
+    // it ran any of the loop itself, so it only waits for the workers
+    thread_pool_.parallel_for(begin, end, grain_size, body, loop_thread_limit, has_slot);
+}
+
+}
@@ -0,0 +1,180 @@
+#include "thread_pool.h"
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <latch>
+#include <mutex>
+#include <stop_token>
+#include <thread>
+#include <vector>
+
+namespace
+{
+
+/** Flag set while a thread is running a chunk of a loop, used to detect nested loops. */
+thread_local auto in_parallel_for = false;
+
+}
+
+namespace bab
+{
+
+ThreadPool::ThreadPool(std::uint32_t thread_count, const std::function<void()> &on_worker_start)
+    : workers_()
+    , loop_mutex_()
+    , mutex_()
+    , work_available_()
+    , work_complete_()
+    , body_(nullptr)
+    , next_(0)
+    , end_(0)
+    , grain_size_(1)
+    , job_id_(0u)
+    , busy_workers_(0u)
+    , open_slots_(0)
+{
+    const auto worker_count = std::max(thread_count, 1u) - 1u;
+    std::latch started{static_cast<std::ptrdiff_t>(worker_count)};
+
+    for (auto i = 0u; i < worker_count; ++i)
+    {
+        workers_.emplace_back([this, &on_worker_start, &started](std::stop_token stop_token) {
+            if (on_worker_start)
+            {
+                on_worker_start();
+            }
+            started.count_down();
+
+            worker_loop(stop_token);
+        });
+    }
+
+    // the latch and start function are borrowed by the workers
+    started.wait();
+}
+
+ThreadPool::~ThreadPool()
+{
+    for (auto &worker : workers_)
+    {
+        worker.request_stop();
+    }
+
+    // jthread destructor joins
+    workers_.clear();
+}
+
+std::uint32_t ThreadPool::thread_count() const
+{
+    return static_cast<std::uint32_t>(workers_.size()) + 1u;
+}
+
+void ThreadPool::parallel_for(
+    std::int32_t begin,
+    std::int32_t end,
+    std::int32_t grain_size,
+    const std::function<void(std::int32_t, std::int32_t)> &body,
+    std::uint32_t max_threads,
+    bool run_on_caller)
+{
+    grain_size = std::max(grain_size, 1);
+
+    if (begin >= end)
+    {
+        return;
+    }
+
+    const auto thread_limit = (max_threads == 0u) ? thread_count() : std::min(max_threads, thread_count());
+
+    // we are already inside a loop and the workers are busy, or the loop is not worth waking the workers for
+    if (in_parallel_for || workers_.empty() ||
+        (run_on_caller && ((thread_limit == 1u) || ((end - begin) <= grain_size))))
+    {
+        body(begin, end);
+        return;
+    }
+
+    const auto worker_limit = run_on_caller ? thread_limit - 1u : thread_limit;
+
+    std::scoped_lock loop_lock{loop_mutex_};
+
+    {
+        std::scoped_lock lock{mutex_};
+        body_ = &body;
+        next_ = begin;
+        end_ = end;
+        grain_size_ = grain_size;
+        busy_workers_ = static_cast<std::uint32_t>(workers_.size());
+        open_slots_ = static_cast<std::int32_t>(std::min<std::size_t>(worker_limit, workers_.size()));
+        ++job_id_;
+    }
+
+    work_available_.notify_all();
+
+    if (run_on_caller)
+    {
+        run_chunks();
+    }
+
+    // the body is only borrowed so we must wait for every worker to be done with it
+    std::unique_lock lock{mutex_};
+    work_complete_.wait(lock, [this] { return busy_workers_ == 0u; });
+    body_ = nullptr;
+}
+
+void ThreadPool::worker_loop(std::stop_token stop_token)
+{
+    auto last_job_id = 0ull;
+
+    for (;;)
+    {
+        {
+            std::unique_lock lock{mutex_};
+            if (!work_available_.wait(lock, stop_token, [this, last_job_id] { return job_id_ != last_job_id; }))
+            {
+                // stop was requested
+                return;
+            }
+
+            last_job_id = job_id_;
+        }
+
+        // every worker acknowledges the loop, but only as many as the loop allows take part
+        if (open_slots_.fetch_sub(1) > 0)
+        {
+            run_chunks();
+        }
+
+        {
+            std::scoped_lock lock{mutex_};
+            if (--busy_workers_ == 0u)
+            {
+                work_complete_.notify_one();
+            }
+        }
+    }
+}
+
+void ThreadPool::run_chunks()
+{
+    in_parallel_for = true;
+
+    for (;;)
+    {
+        const auto chunk_begin = next_.fetch_add(grain_size_);
+        if (chunk_begin >= end_)
+        {
+            break;
+        }
+
+        (*body_)(chunk_begin, std::min(chunk_begin + grain_size_, end_));
+    }
+
+    in_parallel_for = false;
+}
+
+}
@@ -0,0 +1,56 @@
+#include "transform_snapshot.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <optional>
+
+#include "quaternion.h"
+#include "rigid_body.h"
+#include "transform.h"
+#include "vector3.h"
+
+namespace bab
+{
+
+TransformSnapshot::TransformSnapshot()
+    : tick_(0u)
+    , published_()
+    , tick_length_(1.0f)
+    , generations_()
+    , previous_()
+    , current_()
+    , debug_lines_()
+{
+}
+
+std::uint64_t TransformSnapshot::tick() const
+{
+    return tick_;
+}
+
+float TransformSnapshot::interpolation_alpha(std::chrono::steady_clock::time_point now) const
+{
+    const auto elapsed = std::chrono::duration<float>(now - published_).count();
+    return std::clamp(elapsed / tick_length_, 0.0f, 1.0f);
+}
+
+std::optional<Transform> TransformSnapshot::interpolated_transform(const RigidBody &rigid_body, float alpha) const
+{
+    const auto index = rigid_body.index();
+
+    // the body may have been added after the snapshot was taken, or removed and its slot reused
+    if ((index >= generations_.size()) || (generations_[index] != rigid_body.generation()))
+    {
+        return std::nullopt;
+    }
+
+    const auto &previous = previous_[index];
+    const auto &current = current_[index];
+
+    return Transform{
+        previous.position + (current.position - previous.position) * alpha,
+        Quaternion::nlerp(alpha, previous.orientation, current.orientation, true)};
+}
+
+}
@@ -0,0 +1,296 @@
+#include "triangle_mesh.h"
+
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <fstream>
+#include <memory>
+#include <span>
+#include <string>
+#include <system_error>
+#include <type_traits>
+#include <vector>
+
+#include "BulletCollision/CollisionShapes/btBvhTriangleMeshShape.h"
+#include "BulletCollision/CollisionShapes/btOptimizedBvh.h"
+#include "BulletCollision/CollisionShapes/btTriangleIndexVertexArray.h"
+#include "LinearMath/btAlignedAllocator.h"
+#include "LinearMath/btVector3.h"
+#include "Ogre.h"
+
+namespace
+{
+
+/**
+ * Header written at the start of a bvh cache file.
+ */
+struct CacheHeader
+{
+    /** Identifies the file as a bvh cache. */
+    std::uint32_t magic;
+
+    /** Format version, bumped whenever the layout or bullet's serialisation changes. */
+    std::uint32_t version;
+
+    /** Hash of the mesh data the bvh was built for, so edited meshes are rebuilt. */
+    std::uint64_t content_hash;
+
+    /** Size in bytes of the serialised bvh following the header. */
+    std::uint32_t bvh_size;
+
+    /** Always zero, spelled out so the whole header is written with known bytes. */
+    std::uint32_t padding;
+};
+
+static_assert(std::has_unique_object_representations_v<CacheHeader>);
+
+/** Magic value for cache files, "BABH". */
+constexpr auto cache_magic = std::uint32_t{0x48424142};
+
+/** Current cache file version. */
+constexpr auto cache_version = std::uint32_t{1u};
+
+/** Alignment bullet requires for serialised bvh data. */
+constexpr auto bvh_alignment = 16;
+
+/**
+ * Helper function to hash some bytes with FNV-1a.
+ *
+ * @param bytes
+ *   The bytes to hash.
+ *
+ * @param hash
+ *   Hash to continue from, allowing multiple buffers to be hashed together.
+ *
+ * @returns
+ *   Hash of the bytes.
+ */
+std::uint64_t hash_bytes(std::span<const std::byte> bytes, std::uint64_t hash = 0xcbf29ce484222325u)
+{
+    for (const auto byte : bytes)
+    {
+        hash ^= static_cast<std::uint64_t>(byte);
+        hash *= 0x100000001b3u;
+    }
+
+    return hash;
+}
+
+/**
+ * Helper function to get the path of the bvh cache file for a mesh.
+ *
+ * @param mesh_name
+ *   Name of the mesh.
+ *
+ * @returns
+ *   Path next to the mesh file, or an empty path if the mesh does not live in a directory on disk (e.g. a zip).
+ */
+std::filesystem::path cache_path_for(const std::string &mesh_name)
+{
+    auto &resource_manager = ::Ogre::ResourceGroupManager::getSingleton();
+
+    const auto &group = resource_manager.findGroupContainingResource(mesh_name);
+    const auto files = resource_manager.findResourceFileInfo(group, mesh_name);
+
+    if (files->empty() || (files->front().archive->getType() != "FileSystem"))
+    {
+        return {};
+    }
+
+    auto path = std::filesystem::path{files->front().archive->getName()} / files->front().filename;
+    path += ".bvh";
+
+    return path;
+}
+
+}
+
+namespace bab
+{
+
+TriangleMesh::TriangleMesh(const std::string &mesh_name)
+    : vertices_()
+    , indices_()
+    , mesh_interface_()
+    , aabb_min_()
+    , aabb_max_()
+    , built_bvh_()
+    , bvh_buffer_()
+    , bvh_(nullptr)
+{
+    const auto mesh = ::Ogre::MeshManager::getSingleton().load(
+        mesh_name, ::Ogre::ResourceGroupManager::AUTODETECT_RESOURCE_GROUP_NAME);
+
+    // submeshes may share a single vertex buffer, which we only want to copy once
+    auto shared_vertex_offset = -1;
+
+    for (const auto *sub_mesh : mesh->getSubMeshes())
+    {
+        // only triangle lists make sense as collision geometry
+        if (sub_mesh->operationType != ::Ogre::RenderOperation::OT_TRIANGLE_LIST)
+        {
+            continue;
+        }
+
+        const auto *vertex_data = sub_mesh->useSharedVertices ? mesh->sharedVertexData : sub_mesh->vertexData;
+        auto vertex_offset = static_cast<int>(vertices_.size() / 3u);
+
+        if (sub_mesh->useSharedVertices && (shared_vertex_offset != -1))
+        {
+            vertex_offset = shared_vertex_offset;
+        }
+        else
+        {
+            if (sub_mesh->useSharedVertices)
+            {
+                shared_vertex_offset = vertex_offset;
+            }
+
+            const auto *position = vertex_data->vertexDeclaration->findElementBySemantic(::Ogre::VES_POSITION);
+            const auto vertex_buffer = vertex_data->vertexBufferBinding->getBuffer(position->getSource());
+            const ::Ogre::HardwareBufferLockGuard lock{vertex_buffer, ::Ogre::HardwareBuffer::HBL_READ_ONLY};
+
+            const auto *vertex = static_cast<unsigned char *>(lock.pData) +
+                                 (vertex_data->vertexStart * vertex_buffer->getVertexSize());
+
+            for (auto i = 0u; i < vertex_data->vertexCount; ++i)
+            {
+                float *element = nullptr;
+                position->baseVertexPointerToElement(const_cast<unsigned char *>(vertex), &element);
+                vertices_.insert(std::cend(vertices_), element, element + 3);
+
+                vertex += vertex_buffer->getVertexSize();
+            }
+        }
+
+        const auto *index_data = sub_mesh->indexData;
+        const auto index_buffer = index_data->indexBuffer;
+        const ::Ogre::HardwareBufferLockGuard lock{index_buffer, ::Ogre::HardwareBuffer::HBL_READ_ONLY};
+
+        for (auto i = 0u; i < index_data->indexCount; ++i)
+        {
+            const auto index = index_data->indexStart + i;
+            const auto value = (index_buffer->getType() == ::Ogre::HardwareIndexBuffer::IT_32BIT)
+                                   ? static_cast<const std::uint32_t *>(lock.pData)[index]
+                                   : static_cast<const std::uint16_t *>(lock.pData)[index];
+
+            indices_.push_back(static_cast<int>(value) + vertex_offset);
+        }
+    }
+
+    assert(!indices_.empty());
+
+    ::btIndexedMesh indexed_mesh{};
+    indexed_mesh.m_numTriangles = static_cast<int>(indices_.size() / 3u);
+    indexed_mesh.m_triangleIndexBase = reinterpret_cast<const unsigned char *>(indices_.data());
+    indexed_mesh.m_triangleIndexStride = 3 * sizeof(int);
+    indexed_mesh.m_numVertices = static_cast<int>(vertices_.size() / 3u);
+    indexed_mesh.m_vertexBase = reinterpret_cast<const unsigned char *>(vertices_.data());
+    indexed_mesh.m_vertexStride = 3 * sizeof(float);
+    indexed_mesh.m_indexType = PHY_INTEGER;
+    indexed_mesh.m_vertexType = PHY_FLOAT;
+
+    mesh_interface_.addIndexedMesh(indexed_mesh, PHY_INTEGER);
+    mesh_interface_.calculateAabbBruteForce(aabb_min_, aabb_max_);
+
+    // hashing the mesh is far cheaper than building a bvh for it, and means an edited mesh never uses a stale cache
+    const auto content_hash =
+        hash_bytes(std::as_bytes(std::span{indices_}), hash_bytes(std::as_bytes(std::span{vertices_})));
+    const auto cache_path = cache_path_for(mesh_name);
+
+    if (cache_path.empty() || !load_bvh(cache_path, content_hash))
+    {
+        built_bvh_ = std::make_unique<::btOptimizedBvh>();
+        built_bvh_->build(&mesh_interface_, true, aabb_min_, aabb_max_);
+        bvh_ = built_bvh_.get();
+
+        if (!cache_path.empty())
+        {
+            save_bvh(cache_path, content_hash);
+        }
+    }
+}
+
+TriangleMesh::~TriangleMesh()
+{
+    // a loaded bvh was constructed in place in the buffer, so has to be destroyed before the buffer is freed
+    if (bvh_buffer_)
+    {
+        std::destroy_at(bvh_);
+    }
+}
+
+std::unique_ptr<::btBvhTriangleMeshShape> TriangleMesh::create_shape()
+{
+    auto shape = std::make_unique<::btBvhTriangleMeshShape>(&mesh_interface_, true, aabb_min_, aabb_max_, false);
+    shape->setOptimizedBvh(bvh_);
+
+    return shape;
+}
+
+void TriangleMesh::AlignedDeleter::operator()(void *buffer) const
+{
+    ::btAlignedFree(buffer);
+}
+
+bool TriangleMesh::load_bvh(const std::filesystem::path &cache_path, std::uint64_t content_hash)
+{
+    std::ifstream file{cache_path, std::ios::binary};
+
+    CacheHeader header{};
+    if (!file.read(reinterpret_cast<char *>(&header), sizeof(header)) || (header.magic != cache_magic) ||
+        (header.version != cache_version) || (header.content_hash != content_hash))
+    {
+        return false;
+    }
+
+    std::unique_ptr<void, AlignedDeleter> buffer{::btAlignedAlloc(header.bvh_size, bvh_alignment)};
+    if (!file.read(static_cast<char *>(buffer.get()), header.bvh_size))
+    {
+        return false;
+    }
+
+    auto *bvh = ::btOptimizedBvh::deSerializeInPlace(buffer.get(), header.bvh_size, false);
+    if (bvh == nullptr)
+    {
+        return false;
+    }
+
+    // btOptimizedBvh adds no data to btQuantizedBvh, bullet's own loaders rely on this cast too
+    bvh_ = static_cast<::btOptimizedBvh *>(bvh);
+    bvh_buffer_ = std::move(buffer);
+
+    return true;
+}
+
+void TriangleMesh::save_bvh(const std::filesystem::path &cache_path, std::uint64_t content_hash) const
+{
+    const auto bvh_size = bvh_->calculateSerializeBufferSize();
+
+    std::unique_ptr<void, AlignedDeleter> buffer{::btAlignedAlloc(bvh_size, bvh_alignment)};
+    if (!bvh_->serialize(buffer.get(), bvh_size, false))
+    {
+        return;
+    }
+
+    CacheHeader header{};
+    header.magic = cache_magic;
+    header.version = cache_version;
+    header.content_hash = content_hash;
+    header.bvh_size = bvh_size;
+
+    std::ofstream file{cache_path, std::ios::binary | std::ios::trunc};
+    file.write(reinterpret_cast<const char *>(&header), sizeof(header));
+    file.write(static_cast<const char *>(buffer.get()), bvh_size);
+    file.close();
+
+    // a partial file would fail its load and be rebuilt anyway, but there is no point leaving it around
+    if (!file.good())
+    {
+        std::error_code error{};
+        std::filesystem::remove(cache_path, error);
+    }
+}
+
+}
@@ -0,0 +1,24 @@
+#include "trigger_volume.h"
+
+#include <cstdint>
+
+namespace bab
+{
+
+TriggerVolume::TriggerVolume(std::uint32_t index, std::uint32_t generation)
+    : index_(index)
+    , generation_(generation)
+{
+}
+
+std::uint32_t TriggerVolume::index() const
+{
+    return index_;
+}
+
+std::uint32_t TriggerVolume::generation() const
+{
+    return generation_;
+}
+
+}